@@ -18,9 +18,11 @@ void show_usage(const std::string& name) {
 	std::cerr << "Supported input file formats:" << std::endl;
 	std::cerr << "  .real                       " << std::endl;
 	std::cerr << "  .qasm                       " << std::endl;
+	std::cerr << "  .qfr (binary)               " << std::endl;
 	std::cerr << "Supported output file formats:" << std::endl;
 	std::cerr << "  .qasm                       " << std::endl;
 	std::cerr << "  .py (qiskit)                " << std::endl;
+	std::cerr << "  .qfr (binary)               " << std::endl;
 	std::cerr << "If '--remove_gates X' is specified, X gates are randomly removed" << std::endl;
 }
 
@@ -45,6 +47,8 @@ int main(int argc, char** argv){
 		informat = qc::Real;
 	} else if (extension == "qasm") {
 		informat = qc::OpenQASM;
+	} else if (extension == "qfr") {
+		informat = qc::Binary;
 	} else {
 		show_usage(argv[0]);
 		return 1;
@@ -60,6 +64,8 @@ int main(int argc, char** argv){
 		outformat = qc::Qiskit;
 	} else if (extension == "qasm") {
 		outformat = qc::OpenQASM;
+	} else if (extension == "qfr") {
+		outformat = qc::Binary;
 	} else {
 		show_usage(argv[0]);
 		return 1;
@@ -81,19 +87,17 @@ int main(int argc, char** argv){
 		std::function<unsigned long long()> rng = [&]() { return distribution(mt); };
 
 		std::set<unsigned long long> already_removed{};
+		gates_to_remove = std::min<unsigned long long>(gates_to_remove, qc.getNops());
 
 		for (unsigned long long j=0; j < gates_to_remove; ++j) {
-			auto gate_to_remove = rng() % qc.getNops();
+			auto gate_to_remove = rng();
 			while (already_removed.count(gate_to_remove)) {
-				gate_to_remove = rng() % qc.getNops();
+				gate_to_remove = rng();
 			}
 			already_removed.insert(gate_to_remove);
-			auto it = qc.begin();
-			if (it == qc.end()) continue;
-			std::advance(it, gate_to_remove);
-
-			qc.erase(it);
+			qc.markDeleted(gate_to_remove);
 		}
+		qc.compact();
 	}
 
 	qc.dump(outfile, outformat);
@@ -7,22 +7,74 @@
 #define QCEC_CIRCUITOPTIMIZER_HPP
 
 #include "QuantumComputation.hpp"
-#include <forward_list>
+#include "DAG.hpp"
 
-namespace qc {
-	using DAG = std::vector<std::forward_list<std::unique_ptr<Operation>*>>;
+#include <numeric>
 
+namespace qc {
 	class CircuitOptimizer {
-
 	protected:
-		static void addToDag(DAG& dag, std::unique_ptr<Operation> *op);
+		// basis in which an operation acts diagonally on a given qubit (Identity if it does not act on the qubit)
+		enum class Basis { Identity, Z, X, None };
+		static Basis basisOf(const Operation& op, unsigned short qubit);
+		static bool isInverse(const Operation& a, const Operation& b);
+		static GateMatrix multiply(const GateMatrix& a, const GateMatrix& b);
+		// phase lambda of a diagonal single-qubit gate diag(1, e^(i lambda)); returns false if op is no such gate
+		static bool phaseOf(const Operation& op, fp& lambda);
+		static bool isCNOT(const Operation& op);
+
 	public:
+		// replaces every qubit q the operation acts on by relabeling[q]
+		static void relabel(Operation& op, const std::vector<unsigned short>& relabeling);
+
+		static constexpr std::size_t DEFAULT_CANCELLATION_WINDOW = 64;
+		static constexpr std::size_t FAST_CANCELLATION_WINDOW = 16; // used by PassManager::fast()
+		static constexpr std::size_t DEFAULT_SCHEDULING_LOOKAHEAD = 4;
+
 		CircuitOptimizer() = default;
 
 		static DAG constructDAG(QuantumComputation& qc);
+
+		// the overloads taking a DAG update it incrementally, such that several passes can share the same DAG.
+		// They leave deleted operations as tombstones and keep inserted operations in the DAG, i.e., the circuit
+		// must not be used otherwise before DAG::compact() has been called once all passes are done.
 		static void swapGateFusion(QuantumComputation& qc);
-		static void singleGateFusion(QuantumComputation& qc);
+		static void swapGateFusion(DAG& dag); // requires DAG::compact() afterwards
+		// if numeric is set, runs of single-qubit gates are multiplied and replaced by a single (U3 or named) gate instead of a compound operation
+		static void singleGateFusion(QuantumComputation& qc, bool numeric = false);
+		static void singleGateFusion(DAG& dag, bool numeric = false); // requires DAG::compact() afterwards
 		static void removeIdentities(QuantumComputation& qc);
+		static void removeIdentities(DAG& dag); // requires DAG::compact() afterwards
+
+		// sufficient condition for two operations to commute, i.e., on every shared qubit both are diagonal in the same basis
+		static bool commute(const Operation& a, const Operation& b);
+		// cancels pairs of mutually inverse gates that are only separated by gates commuting with them.
+		// for every gate, at most window gates preceding it are examined.
+		static void cancelInverseGates(QuantumComputation& qc, std::size_t window = DEFAULT_CANCELLATION_WINDOW);
+		static void cancelInverseGates(DAG& dag, std::size_t window = DEFAULT_CANCELLATION_WINDOW); // requires DAG::compact() afterwards
+
+		// replaces maximal blocks of (at least two) consecutive gates acting on at most maxBlockQubits qubits by a single
+		// MatrixOperation, whose decision diagram is constructed directly from the block's unitary.
+		// the original gates are kept within the matrix operation for exporting the circuit.
+		static void consolidateBlocks(QuantumComputation& qc, unsigned short maxBlockQubits = 2);
+		static void consolidateBlocks(DAG& dag, unsigned short maxBlockQubits = 2); // requires DAG::compact() afterwards
+
+		// merges diagonal rotations (Z, S, T, U1, RZ and their inverses) acting on the same parity of qubits within
+		// regions consisting only of CNOT, X, SWAP and diagonal gates (i.e., regions described by a phase polynomial).
+		// every parity is rotated at most once per region, namely at its first occurrence.
+		static void mergeRotations(QuantumComputation& qc);
+		static void mergeRotations(DAG& dag); // requires DAG::compact() afterwards
+
+		// removes all (uncontrolled) SWAP gates, including those given as three alternating CNOTs, by relabeling the
+		// qubits of all subsequent operations. The resulting permutation is reflected in the output permutation.
+		static void eliminateSwaps(QuantumComputation& qc);
+		static void eliminateSwaps(DAG& dag); // requires DAG::compact() afterwards
+
+		// reorders the operations such that the intermediate decision diagrams during the construction of the
+		// functionality stay small. In every step, all operations among the first lookahead+1 pending operations on
+		// any qubit that commute with all pending operations preceding them are tried on the current functionality
+		// and the one yielding the smallest DD is scheduled next. The resulting circuit is functionally equivalent.
+		static void scheduleForDDSize(QuantumComputation& qc, std::unique_ptr<dd::Package>& dd, std::size_t lookahead = DEFAULT_SCHEDULING_LOOKAHEAD);
 	};
 }
 #endif //QCEC_CIRCUITOPTIMIZER_HPP
@@ -0,0 +1,151 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#ifndef INTERMEDIATEREPRESENTATION_DAG_H
+#define INTERMEDIATEREPRESENTATION_DAG_H
+
+#include "QuantumComputation.hpp"
+
+#include <vector>
+#include <limits>
+#include <iterator>
+#include <memory>
+
+namespace qc {
+	/**
+	 * Dependency graph of the operations of a quantum computation.
+	 *
+	 * Nodes are identified by the index of the corresponding operation in the circuit.
+	 * Every node stores, for each wire it acts on, its predecessor and successor on that wire.
+	 * These links are stored contiguously (one slot per node and wire), such that traversing
+	 * and updating the graph does not require any allocations.
+	 * Qubits are wires [0, nqubits), classical bits are modelled as additional wires [nqubits, nqubits + nclassics).
+	 *
+	 * Removing or replacing a node is O(number of wires of the node) and is directly reflected in the
+	 * circuit (as a tombstone, see QuantumComputation::markDeleted). Inserted nodes get the next free id and occupy
+	 * an empty slot appended to the circuit, their operations are kept by the DAG and moved to their position in the
+	 * circuit by compact(). Hence, the circuit must not be used otherwise (simulated, dumped, ...) before compact()
+	 * has been called. Node ids stay valid until then.
+	 */
+	class DAG {
+	public:
+		using NodeId = std::size_t;
+		static constexpr NodeId NONE = std::numeric_limits<NodeId>::max();
+
+	protected:
+		QuantumComputation*         qc = nullptr;
+		std::size_t                 nwires = 0;
+		std::size_t                 nqubits = 0;
+
+		// slots [offsets[n], offsets[n+1]) belong to node n
+		std::vector<std::size_t>    offsets{};
+		std::vector<unsigned short> wires{};
+		std::vector<NodeId>         preds{};
+		std::vector<NodeId>         succs{};
+
+		// first and last (alive) node on every wire
+		std::vector<NodeId>         first{};
+		std::vector<NodeId>         last{};
+		std::vector<bool>           removed{};
+		std::size_t                 nremoved = 0;
+
+		// topological order of all nodes (including removed ones) as a doubly linked list
+		std::vector<NodeId>         next{};
+		std::vector<NodeId>         prev{};
+		NodeId                      head = NONE;
+		NodeId                      tail = NONE;
+
+		// nodes [0, nbuilt) stem from the circuit, the operations of all later (inserted) nodes are stored here
+		std::size_t                              nbuilt = 0;
+		std::vector<std::unique_ptr<Operation>> inserted{};
+
+		void build();
+		std::size_t slot(NodeId node, unsigned short wire) const;
+		bool actsOn(NodeId node, unsigned short wire) const;
+		void collectWires(const Operation& op, std::vector<unsigned short>& result) const;
+		std::vector<unsigned short> wiresOf(const Operation& op) const;
+		void unlink(NodeId node);
+		// inserts a node directly behind the given node in topological order (at the front if after is NONE)
+		NodeId insert(NodeId after, std::unique_ptr<Operation>&& op);
+		std::unique_ptr<Operation>& operationOf(NodeId node);
+
+	public:
+		explicit DAG(QuantumComputation& qc);
+
+		// Accessors
+		std::size_t size()           const { return removed.size() - nremoved; }
+		std::size_t getNnodes()      const { return removed.size(); }
+		std::size_t getNwires()      const { return nwires; }
+		bool        isRemoved(NodeId node) const { return removed.at(node); }
+		Operation&  at(NodeId node)  const;
+		QuantumComputation& getCircuit() const { return *qc; }
+
+		// wires the node acts on (in ascending order)
+		std::vector<unsigned short> getWires(NodeId node) const;
+		NodeId predecessor(NodeId node, unsigned short wire) const { return preds[slot(node, wire)]; }
+		NodeId successor(NodeId node, unsigned short wire)   const { return succs[slot(node, wire)]; }
+		NodeId front(unsigned short wire) const { return first.at(wire); }
+		NodeId back(unsigned short wire)  const { return last.at(wire);  }
+		// all distinct predecessors/successors of a node
+		std::vector<NodeId> predecessors(NodeId node) const;
+		std::vector<NodeId> successors(NodeId node) const;
+
+		// Modifiers
+		// unlinks the node from the graph and marks the corresponding operation as deleted
+		void remove(NodeId node);
+		// unlinks the node from the graph and hands over its operation (leaving a tombstone in the circuit)
+		std::unique_ptr<Operation> extract(NodeId node);
+		// replaces the operation of a node by an operation acting on exactly the same wires
+		void replace(NodeId node, std::unique_ptr<Operation>&& op);
+		// insert a new node directly before/after the given (possibly removed) node in topological order and return its id.
+		// insertBefore(NONE, op) appends the node. Finding the neighbors of the new node takes time proportional to the
+		// number of nodes between it and the closest preceding nodes on its wires.
+		NodeId insertBefore(NodeId node, std::unique_ptr<Operation>&& op);
+		NodeId insertAfter(NodeId node, std::unique_ptr<Operation>&& op);
+		// recomputes the wires and links of all nodes after the operations of (arbitrarily many) nodes have been changed
+		// in place to act on other wires. The order of the nodes and their ids are kept.
+		void relink();
+		// moves inserted operations to their position in the circuit, compacts it and rebuilds the graph (node ids are renumbered)
+		void compact();
+
+		// Traversal
+		// iterates the nodes that have not been removed in topological order (which coincides with the order in the
+		// compacted circuit). Nodes may be removed or inserted during the iteration.
+		class const_iterator {
+			const DAG* dag  = nullptr;
+			NodeId     node = 0;
+
+			void skipRemoved() {
+				while (node != NONE && dag->removed[node]) {
+					node = dag->next[node];
+				}
+			}
+
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type        = NodeId;
+			using difference_type   = std::ptrdiff_t;
+			using pointer           = const NodeId*;
+			using reference         = const NodeId&;
+
+			const_iterator(const DAG* dag, NodeId node): dag(dag), node(node) { skipRemoved(); }
+
+			reference operator*() const { return node; }
+			const_iterator& operator++() { node = dag->next[node]; skipRemoved(); return *this; }
+			const_iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+			bool operator==(const const_iterator& other) const { return node == other.node; }
+			bool operator!=(const const_iterator& other) const { return node != other.node; }
+		};
+		const_iterator begin() const { return const_iterator(this, head); }
+		const_iterator end()   const { return const_iterator(this, NONE); }
+
+		// nodes grouped by their ASAP depth, i.e., the length of the longest path from any input
+		std::vector<std::vector<NodeId>> layers() const;
+		std::size_t depth() const { return layers().size(); }
+
+		std::ostream& print(std::ostream& os = std::cout) const;
+	};
+}
+#endif //INTERMEDIATEREPRESENTATION_DAG_H
@@ -0,0 +1,80 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#ifndef INTERMEDIATEREPRESENTATION_DYNAMICCIRCUITSIMULATOR_H
+#define INTERMEDIATEREPRESENTATION_DYNAMICCIRCUITSIMULATOR_H
+
+#include "QuantumComputation.hpp"
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace qc {
+	/**
+	 * Simulates circuits containing mid-circuit measurements, resets and classically controlled operations.
+	 *
+	 * Measurements collapse the state DD onto the observed outcome (and renormalize it) while the outcome is written to
+	 * the classical register. Resets collapse the qubit and flip it back to |0> if necessary. Classically controlled
+	 * operations are applied whenever the controlling register holds the expected value.
+	 *
+	 * Apart from single trajectories, the tree of all measurement outcomes can be explored. When sampling shots this way,
+	 * the shots are split binomially among the outcomes of every measurement, such that the operations before a
+	 * measurement are only applied once for all shots reaching it instead of once per shot.
+	 * Classical bitstrings list bit m-1 first and bit 0 last.
+	 */
+	class DynamicCircuitSimulator {
+	public:
+		struct Branch {
+			std::string classical{};   // contents of the classical register
+			fp          probability = 0.;
+			std::size_t shots = 0;     // number of shots that ended in this branch (when sampling)
+			dd::Edge    state{};       // final state (referenced until released by releaseBranches)
+		};
+
+	protected:
+		struct Step {
+			enum Kind { Apply, Measure, Reset } kind = Apply;
+			const Operation* op    = nullptr;
+			unsigned short   qubit = 0;
+			unsigned short   bit   = 0;
+		};
+
+		QuantumComputation&        qc;
+		std::unique_ptr<dd::Package>& dd;
+		std::mt19937_64            rng;
+		std::vector<Step>          steps{};
+		std::array<short, MAX_QUBITS> line{};
+
+		void compile();
+		bool conditionHolds(const Operation& op, const std::vector<bool>& cbits) const;
+		fp probabilityOfOne(const dd::Edge& e, const permutationMap& map, unsigned short qubit) const;
+		// projects the state onto the given outcome and renormalizes it (the returned edge is referenced)
+		dd::Edge collapse(const dd::Edge& e, const permutationMap& map, unsigned short qubit, bool outcome, fp probability);
+		dd::Edge applyX(dd::Edge e, const permutationMap& map, unsigned short qubit);
+
+		// continues the simulation of a branch (e is referenced and owned by the call). If exhaustive is set, all outcomes
+		// with a probability above the threshold are explored, otherwise the shots are distributed among the outcomes.
+		void explore(std::size_t step, dd::Edge e, permutationMap map, std::vector<bool> cbits, fp probability, std::size_t shots,
+		             bool exhaustive, fp threshold, bool keepStates, std::vector<Branch>& branches);
+
+	public:
+		DynamicCircuitSimulator(QuantumComputation& qc, std::unique_ptr<dd::Package>& dd, std::uint64_t seed = 0);
+
+		// simulates a single trajectory with randomly drawn measurement outcomes
+		Branch simulateShot(const dd::Edge& in);
+		// simulates every shot as a separate trajectory and counts the resulting classical bitstrings
+		std::map<std::string, std::size_t> sampleTrajectories(const dd::Edge& in, std::size_t shots);
+		// same result distribution as sampleTrajectories, but the shots share the simulation of common prefixes
+		std::map<std::string, std::size_t> sampleBranching(const dd::Edge& in, std::size_t shots);
+		// all branches of the measurement tree with a probability above the given threshold
+		std::vector<Branch> simulateBranches(const dd::Edge& in, fp threshold = 0.);
+
+		static void releaseBranches(std::unique_ptr<dd::Package>& dd, std::vector<Branch>& branches);
+	};
+}
+#endif //INTERMEDIATEREPRESENTATION_DYNAMICCIRCUITSIMULATOR_H
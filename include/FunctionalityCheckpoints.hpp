@@ -0,0 +1,58 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#ifndef INTERMEDIATEREPRESENTATION_FUNCTIONALITYCHECKPOINTS_H
+#define INTERMEDIATEREPRESENTATION_FUNCTIONALITYCHECKPOINTS_H
+
+#include "QuantumComputation.hpp"
+
+namespace qc {
+	/**
+	 * Builds the functionality of a circuit while keeping intermediate products, such that the functionality can be
+	 * rebuilt quickly after the circuit has been edited.
+	 *
+	 * The (ref-counted) product of the first i*interval operations is kept for every i. Optionally, the products of the
+	 * remaining operations starting at these positions are kept as well. All checkpoints belong to the package given on
+	 * construction and are released when the object is destroyed (or cleared), i.e., the package has to outlive the object.
+	 * The checkpoints always describe the circuit at the time of build, which suits edit/rebuild/revert workflows.
+	 */
+	class FunctionalityCheckpoints {
+	protected:
+		struct Checkpoint {
+			std::size_t    position = 0; // first operation not contained in a prefix (or first operation contained in a suffix)
+			dd::Edge       e{};
+			permutationMap map{};        // qubit mapping at the position
+		};
+
+		QuantumComputation&           qc;
+		std::unique_ptr<dd::Package>& dd;
+		std::vector<Checkpoint>       prefixes{};
+		std::vector<Checkpoint>       suffixes{};
+		std::size_t                   nops = 0;
+		permutationMap                finalMap{};
+
+		const Operation& operation(std::size_t i) const { return **(qc.begin() + static_cast<std::ptrdiff_t>(i)); }
+
+	public:
+		FunctionalityCheckpoints(QuantumComputation& qc, std::unique_ptr<dd::Package>& dd): qc(qc), dd(dd) {}
+		~FunctionalityCheckpoints() { clear(); }
+
+		FunctionalityCheckpoints(const FunctionalityCheckpoints&) = delete;
+		FunctionalityCheckpoints& operator=(const FunctionalityCheckpoints&) = delete;
+
+		// same as QuantumComputation::buildFunctionality, but the checkpoints are recorded on the way (replacing previous ones)
+		dd::Edge build(std::size_t interval, bool storeSuffixes = false);
+		// rebuilds the functionality after the circuit has been edited, where [editBegin, editEnd) is the range of operations
+		// that differ from the circuit the checkpoints were built for (all operations before editBegin are unchanged and the
+		// operations from editEnd onwards correspond to the last operations of that circuit). The construction restarts from
+		// the last prefix checkpoint before editBegin and reuses a suffix product after editEnd if the qubit mapping permits.
+		// The checkpoints are not changed, i.e., subsequent edits have to refer to the same base circuit.
+		dd::Edge rebuild(std::size_t editBegin, std::size_t editEnd);
+		void clear();
+
+		std::size_t size() const { return prefixes.size() + suffixes.size(); }
+	};
+}
+#endif //INTERMEDIATEREPRESENTATION_FUNCTIONALITYCHECKPOINTS_H
@@ -0,0 +1,95 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#ifndef INTERMEDIATEREPRESENTATION_PASSMANAGER_H
+#define INTERMEDIATEREPRESENTATION_PASSMANAGER_H
+
+#include "CircuitOptimizer.hpp"
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace qc {
+	struct CircuitMetrics {
+		unsigned long long nops        = 0; // individual operations (operations within compound operations are counted separately, matrix operations count as one)
+		unsigned long long nmultiQubit = 0; // individual operations acting on at least two qubits
+		std::size_t        depth       = 0; // number of layers of the dependency graph
+
+		static CircuitMetrics of(QuantumComputation& qc);
+		static CircuitMetrics of(const DAG& dag);
+
+		bool operator==(const CircuitMetrics& other) const {
+			return nops == other.nops && nmultiQubit == other.nmultiQubit && depth == other.depth;
+		}
+		bool operator!=(const CircuitMetrics& other) const { return !(*this == other); }
+
+		std::ostream& printJSON(std::ostream& os) const;
+	};
+
+	struct PassStatistics {
+		std::string    name{};
+		std::size_t    iteration = 0;
+		double         runtime   = 0.; // in seconds
+		CircuitMetrics before{};
+		CircuitMetrics after{};
+	};
+
+	/**
+	 * Runs a pipeline of optimization passes on a quantum computation.
+	 *
+	 * Repeated passes are executed in the order they have been added until one iteration over all of them no longer
+	 * changes the circuit metrics or the iteration limit is reached. Afterwards, every final pass is executed once.
+	 * The wall time and the circuit metrics before and after every single pass execution are recorded.
+	 *
+	 * All passes work on a single dependency graph of the circuit, which is only compacted once after the last pass.
+	 * Hence, a pass that has to work on the circuit itself has to call DAG::compact() first.
+	 */
+	class PassManager {
+	public:
+		using Pass = std::function<void(DAG&)>;
+		static constexpr std::size_t DEFAULT_MAX_ITERATIONS = 10;
+
+	protected:
+		struct Entry {
+			std::string name;
+			Pass        pass;
+			bool        repeat;
+		};
+		std::vector<Entry>          passes{};
+		std::size_t                 maxIterations = DEFAULT_MAX_ITERATIONS;
+
+		std::vector<PassStatistics> statistics{};
+		CircuitMetrics              initial{};
+		CircuitMetrics              result{};
+		std::size_t                 iterations = 0;
+		bool                        converged = false;
+
+		void execute(const Entry& entry, DAG& dag, std::size_t iteration, CircuitMetrics& metrics);
+
+	public:
+		explicit PassManager(std::size_t maxIterations = DEFAULT_MAX_ITERATIONS): maxIterations(maxIterations) {}
+
+		// passes which should only be applied once (e.g., because they produce operations other passes cannot handle) are added with repeat = false
+		PassManager& addPass(const std::string& name, Pass pass, bool repeat = true);
+
+		// cheap cleanup of the circuit (inverse gates, runs of single-qubit gates, identities)
+		static PassManager fast();
+		// additionally eliminates SWAPs, merges rotations across CNOTs and consolidates two-qubit blocks into matrix operations
+		static PassManager aggressive();
+
+		void run(QuantumComputation& qc);
+
+		const std::vector<PassStatistics>& getStatistics() const { return statistics; }
+		std::size_t getIterations() const { return iterations; }
+		bool hasConverged() const { return converged; }
+		std::size_t getNpasses() const { return passes.size(); }
+
+		std::ostream& printStatistics(std::ostream& os = std::cout) const;
+		void dumpStatistics(const std::string& filename) const;
+	};
+}
+#endif //INTERMEDIATEREPRESENTATION_PASSMANAGER_H
@@ -0,0 +1,62 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#ifndef INTERMEDIATEREPRESENTATION_PAULIEXPECTATION_H
+#define INTERMEDIATEREPRESENTATION_PAULIEXPECTATION_H
+
+#include "QuantumComputation.hpp"
+
+#include <complex>
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace qc {
+	/**
+	 * Evaluates expectation values <psi|P|psi> of Pauli strings P on a state DD.
+	 *
+	 * The value is computed by a simultaneous traversal of two copies of the state, applying the Pauli operator of
+	 * every variable on the fly. Hence, no DD nodes are created at all and strings consisting of I and Z only visit
+	 * diagonal node pairs exclusively. Intermediate results are cached per node pair and remaining (lower) part of the
+	 * string, such that strings sharing a suffix share the corresponding part of the traversal.
+	 * Pauli strings list qubit n-1 first and qubit 0 last, where qubit q is represented by variable varMap[q].
+	 * The state has to stay referenced while the evaluator is used.
+	 */
+	class PauliExpectation {
+	public:
+		using Observable = std::vector<std::pair<fp, std::string>>; // weighted sum of Pauli strings
+
+	protected:
+		dd::Edge                    root{};
+		unsigned short              nqubits = 0;
+		std::vector<unsigned short> qubitAt{}; // qubit represented by each variable
+
+		// identifiers of the parts of Pauli strings acting on variables 0, ..., v (0 refers to the empty part)
+		std::map<std::pair<std::size_t, char>, std::size_t>                                suffixes{};
+		std::map<std::tuple<dd::NodePtr, dd::NodePtr, std::size_t>, std::complex<fp>> computeTable{};
+
+		std::complex<fp> expectation(dd::NodePtr x, dd::NodePtr y, short v, const std::string& paulis, const std::vector<std::size_t>& suffixIds);
+		std::complex<fp> inner(const dd::Edge& x, const dd::Edge& y, short v, const std::string& paulis, const std::vector<std::size_t>& suffixIds);
+
+	public:
+		PauliExpectation(const dd::Edge& state, unsigned short nqubits, const permutationMap& varMap = Operation::standardPermutation);
+
+		// expectation value of a single Pauli string over {I, X, Y, Z}
+		fp expectation(const std::string& pauli);
+		// expectation values of several Pauli strings sharing the cache
+		std::vector<fp> expectation(const std::vector<std::string>& paulis);
+		// expectation value of a weighted sum of Pauli strings
+		fp expectation(const Observable& observable);
+
+		std::size_t getCacheSize() const { return computeTable.size(); }
+		void clearCache() {
+			computeTable.clear();
+			suffixes.clear();
+		}
+	};
+}
+#endif //INTERMEDIATEREPRESENTATION_PAULIEXPECTATION_H
@@ -9,6 +9,8 @@
 #include "operations/StandardOperation.hpp"
 #include "operations/NonUnitaryOperation.hpp"
 #include "operations/ClassicControlledOperation.hpp"
+#include "operations/CompoundOperation.hpp"
+#include "operations/MatrixOperation.hpp"
 #include "qasm_parser/Parser.hpp"
 
 #include <vector>
@@ -22,6 +24,10 @@
 #include <regex>
 #include <limits>
 #include <string>
+#include <thread>
+#include <cstdint>
+#include <exception>
+#include <functional>
 
 #define DEBUG_MODE_QC 0
 
@@ -35,6 +41,24 @@ namespace qc {
 	static constexpr char DEFAULT_ANCREG[4]{"anc"};
 	static constexpr char DEFAULT_MCTREG[4]{"mct"};
 
+	// binary circuit files start with this magic number followed by the format version
+	static constexpr char          BINARY_MAGIC[4]{'Q', 'F', 'R', 'B'};
+	static constexpr std::uint16_t BINARY_VERSION = 1;
+
+	// file buffer size used when dumping and minimum number of ops formatted per thread
+	static constexpr std::size_t DUMP_BUFFER_SIZE = 1u << 20u;
+	static constexpr std::size_t DUMP_MIN_CHUNK = 1024;
+
+	// state recorded by a Snapshot or ShowProbabilities operation during simulation
+	struct StateSnapshot {
+		std::size_t                 op   = 0;        // index of the operation
+		OpType                      type = Snapshot;
+		int                         id   = 0;        // identifier given by the snapshot operation
+		std::vector<unsigned short> qubits{};        // qubits of the snapshot (all qubits for ShowProbabilities)
+		dd::Edge                    state{};         // referenced until released by QuantumComputation::releaseSnapshots
+		permutationMap              varMap{};        // qubit -> DD variable at the time of the snapshot
+	};
+
 	class CircuitOptimizer;
 
 	class QuantumComputation {
@@ -57,8 +81,14 @@ namespace qc {
 		int readRealHeader(std::istream& is);
 		void readRealGateDescriptions(std::istream& is, int line);
 		void importOpenQASM(std::istream& is);
+		void importOpenQASMParallel(std::istream& is, unsigned int nthreads);
+		static std::size_t findOpenQASMStatementEnd(const std::string& content, std::size_t pos, char delimiter);
 		void importGRCS(std::istream& is);
 		void importTFC(std::istream& is);
+		void importBinary(std::istream& is);
+		void importBinary(const std::string& filename);
+		void importBinary(const char* data, std::size_t size);
+		std::unique_ptr<Operation> importBinaryOperation(const char* data, std::size_t size, std::size_t& pos);
 		int readTFCHeader(std::istream& is, std::map<std::string, unsigned short>& varMap);
 		void readTFCGateDescriptions(std::istream& is, int line, std::map<std::string, unsigned short>& varMap);
 
@@ -66,6 +96,8 @@ namespace qc {
 		static void consolidateRegister(registerMap& regs);
 
 		static void create_reg_array(const registerMap& regs, regnames_t& regnames, unsigned short defaultnumber, const char* defaultname);
+		// formats the ops in contiguous ranges using up to nthreads threads and writes them to the stream in order
+		void dumpOperations(std::ostream& of, unsigned int nthreads, const std::function<void(const Operation&, std::ostream&)>& dumpOperation) const;
 
 		unsigned short getSmallestAncillary() const {
 			for (auto i=0; i<ancillary.size(); ++i) {
@@ -103,6 +135,7 @@ namespace qc {
 		unsigned short  getNqubits()                const { return nqubits + nancillae;	}
 		unsigned short getNancillae()               const { return nancillae; }
 		unsigned short getNqubitsWithoutAncillae()  const { return nqubits; }
+		unsigned short getNcbits()                  const { return nclassics; }
 		std::string     getName()                   const { return name;       }
 		const registerMap& getQregs()               const { return qregs; }
 		const registerMap& getCregs()               const { return cregs; }
@@ -123,6 +156,10 @@ namespace qc {
 		unsigned short getHighestLogicalQubitIndex() const { return getHighestLogicalQubitIndex(initialLayout); };
 		std::pair<std::string, unsigned short> getQubitRegisterAndIndex(unsigned short physical_qubit_index);
 		void reduceAncillae(dd::Edge& e, std::unique_ptr<dd::Package>& dd, const permutationMap& varMap);
+		// checks that the map assigns distinct variables to all qubits and extends it by the identity for all remaining indices
+		permutationMap completeVariableOrder(const permutationMap& varMap) const;
+		// records the state if op is a Snapshot or ShowProbabilities operation. Returns true if op does not alter the state.
+		bool recordSnapshot(const Operation& op, std::size_t index, const dd::Edge& e, const permutationMap& varMap, std::vector<StateSnapshot>& snapshots, std::unique_ptr<dd::Package>& dd) const;
 		std::pair<std::string, unsigned short> getClassicalRegisterAndIndex(unsigned short classical_index);
 		bool isIdleQubit(unsigned short physical_qubit);
 		bool physicalQubitIsAncillary(unsigned short physical_qubit_index);
@@ -134,6 +171,7 @@ namespace qc {
 		// works for reversible circuits --- to be tested for quantum circuits
 		dd::Edge reduceGarbage(dd::Edge& e, std::unique_ptr<dd::Package>& dd, bool regular = true);
 		dd::Edge createInitialMatrix(std::unique_ptr<dd::Package>& dd); // creates identity matrix, which is reduced with respect to the ancillary qubits
+		dd::Edge createInitialMatrix(std::unique_ptr<dd::Package>& dd, const permutationMap& varMap); // same as above, but with the qubit q represented by variable varMap[q]
 
 		/// strip away qubits with no operations applied to them and which do not pop up in the output permutation
 		/// \param force if true, also strip away idle qubits occurring in the output permutation
@@ -144,11 +182,18 @@ namespace qc {
 		static void changePermutation2(dd::Edge& on, qc::permutationMap& from, const qc::permutationMap& to, const qc::permutationMap& varMap, std::array<short, qc::MAX_QUBITS>& line, std::unique_ptr<dd::Package>& dd, bool regular = true);
 
 		void import(const std::string& filename);
-		void import(const std::string& filename, Format format);
+		void import(const std::string& filename, Format format) {
+			import(filename, format, 1);
+		}
 		void import(std::istream& is, Format format) {
 			import(std::move(is), format);
 		}
-		void import(std::istream&& is, Format format);
+		void import(std::istream&& is, Format format) {
+			import(std::move(is), format, 1);
+		}
+		// OpenQASM files are parsed in chunks using up to nthreads threads (other formats are always parsed sequentially)
+		void import(const std::string& filename, Format format, unsigned int nthreads);
+		void import(std::istream&& is, Format format, unsigned int nthreads);
 
 		// search through .qasm file and look for IO layout information of the form
 		//      'i Q_i Q_j ... Q_k' meaning, e.g. q_0 is mapped to Q_i, q_1 to Q_j, etc.
@@ -180,6 +225,61 @@ namespace qc {
 		virtual dd::Edge simulate(const dd::Edge& in, std::unique_ptr<dd::Package>& dd);
 		virtual std::pair<dd::Edge, permutationMap> simulate(const dd::Edge& in, std::unique_ptr<dd::Package>& dd, dd::DynamicReorderingStrategy strat);
 
+		// output each qubit ends up at when the output permutation is established at the end of the circuit (as by changePermutation)
+		std::vector<unsigned short> outputPositions() const;
+
+		// whether the circuit only consists of Clifford operations (see StabilizerSimulator)
+		bool isClifford() const;
+		// samples all (output) qubits at the end of the circuit, bitstrings list qubit n-1 first. Clifford circuits are
+		// simulated on a stabilizer tableau (including mid-circuit measurements and resets), all others by decision diagrams.
+		std::map<std::string, std::size_t> sample(std::size_t shots, std::unique_ptr<dd::Package>& dd, std::uint64_t seed = 0);
+		// expectation value of a Pauli string (listing qubit n-1 first) with respect to the final state of the circuit,
+		// dispatched in the same way as sample. Circuits containing measurements or resets are not supported.
+		fp expectationValue(const std::string& pauli, std::unique_ptr<dd::Package>& dd);
+
+		// backward light cone of the given (output) qubits, i.e., flags for all operations that may influence the state of these qubits at the end of the circuit
+		std::vector<bool> lightCone(const std::vector<unsigned short>& qubits) const;
+		// same as simulate, but only operations within the light cone of the given qubits are applied. The reduced state of
+		// these qubits matches the one obtained by simulate, while all other qubits are not (fully) evolved.
+		dd::Edge simulateLightCone(const dd::Edge& in, std::unique_ptr<dd::Package>& dd, const std::vector<unsigned short>& qubits);
+
+		// the following overloads start from the given variable order (logical qubit -> DD variable) instead of the standard one.
+		// for simulation, the input state has to be given with respect to this order as well.
+		virtual std::pair<dd::Edge, permutationMap> buildFunctionality(std::unique_ptr<dd::Package>& dd, dd::DynamicReorderingStrategy strat, const permutationMap& initialVarMap);
+		virtual std::pair<dd::Edge, permutationMap> simulate(const dd::Edge& in, std::unique_ptr<dd::Package>& dd, dd::DynamicReorderingStrategy strat, const permutationMap& initialVarMap);
+
+		// the following overloads additionally record the (shared, ref-counted) state at every Snapshot and ShowProbabilities
+		// operation. The recorded states have to be released by releaseSnapshots once they are no longer needed.
+		virtual dd::Edge simulate(const dd::Edge& in, std::unique_ptr<dd::Package>& dd, std::vector<StateSnapshot>& snapshots);
+		virtual std::pair<dd::Edge, permutationMap> simulate(const dd::Edge& in, std::unique_ptr<dd::Package>& dd, dd::DynamicReorderingStrategy strat, const permutationMap& initialVarMap, std::vector<StateSnapshot>& snapshots);
+		static void releaseSnapshots(std::unique_ptr<dd::Package>& dd, std::vector<StateSnapshot>& snapshots);
+
+		// simulates the circuit on all inputs at once: every gate DD is constructed once and applied to all states before
+		// moving on to the next gate, such that the compute tables are shared among the states. Garbage collection only
+		// happens in between gates. The results are returned in the order of the inputs.
+		virtual std::vector<dd::Edge> simulateBatch(const std::vector<dd::Edge>& inputs, std::unique_ptr<dd::Package>& dd);
+
+		// probabilities of all outcomes of measuring the given qubits of a state (without expanding the state), where bit k
+		// of the index corresponds to qubits[k] and qubit q is represented by variable varMap[q]
+		static std::vector<fp> getMarginalProbabilities(const dd::Edge& state, const std::vector<unsigned short>& qubits, const permutationMap& varMap = Operation::standardPermutation);
+		static std::vector<fp> getMarginalProbabilities(const StateSnapshot& snapshot) {
+			return getMarginalProbabilities(snapshot.state, snapshot.qubits, snapshot.varMap);
+		}
+
+		// static variable order heuristic based on the interaction graph of the circuit (Cuthill-McKee):
+		// qubits interacting frequently are assigned adjacent variables. The order is reversed if that places the qubits
+		// mostly acting as controls closer to the top
+		permutationMap computeStaticVariableOrder() const;
+
+		// groups of physical qubits which are (transitively) connected by the operations of the circuit
+		std::vector<std::vector<unsigned short>> getConnectedComponents() const;
+		// builds the functionality of every connected component separately (using up to nthreads threads with separate packages)
+		// and assembles the result as the tensor product of the individual functionalities. Since the qubits of a component
+		// are represented by adjacent variables, the resulting variable order (logical qubit -> DD variable) is returned as well.
+		// Garbage outputs are placed as by buildFunctionality. If the (completed) output permutation mixes the components,
+		// the functionality is built as a whole.
+		std::pair<dd::Edge, permutationMap> buildFunctionalityByComponents(std::unique_ptr<dd::Package>& dd, unsigned int nthreads = 1);
+
 		/// Obtain vector/matrix entry for row i (and column j). Does not include common factor e.w!
 		/// \param dd package to use
 		/// \param e vector/matrix dd
@@ -209,13 +309,28 @@ namespace qc {
 
 		static std::ostream& printPermutationMap(const permutationMap& map, std::ostream& os = std::cout);
 
-		virtual void dump(const std::string& filename, Format format);
+		virtual void dump(const std::string& filename, Format format) {
+			dump(filename, format, 1);
+		}
+		// OpenQASM and Qiskit output is formatted in op ranges using up to nthreads threads,
+		// the other formats are only written sequentially (nthreads > 1 is rejected)
+		virtual void dump(const std::string& filename, Format format, unsigned int nthreads);
 		virtual void dump(const std::string& filename);
 		virtual void dump(std::ostream& of, Format format) {
 			dump(std::move(of), format);
 		}
 		virtual void dump(std::ostream&& of, Format format);
-		virtual void dumpOpenQASM(std::ostream& of);
+		virtual void dumpOpenQASM(std::ostream& of) {
+			dumpOpenQASM(of, 1);
+		}
+		virtual void dumpOpenQASM(std::ostream& of, unsigned int nthreads);
+		virtual void dumpQiskit(std::ostream& of) {
+			dumpQiskit(of, 1);
+		}
+		virtual void dumpQiskit(std::ostream& of, unsigned int nthreads);
+		// values are stored in host byte order
+		virtual void dumpBinary(std::ostream& of);
+		static void dumpBinaryOperation(const Operation& op, std::ostream& of);
 
 		virtual void reset() {
 			ops.clear();
@@ -293,6 +408,20 @@ namespace qc {
 		template<class T>
 		std::vector<std::unique_ptr<Operation>>::iterator insert(std::vector<std::unique_ptr<Operation>>::const_iterator pos, T&& op) { return ops.insert(pos, std::forward<T>(op)); }
 
+		// Bulk editing
+		// Operations marked as deleted remain as empty slots (tombstones) until compact() is called.
+		// This allows to remove or replace arbitrary many operations in linear total time.
+		// Indices refer to positions in the (uncompacted) list of operations.
+		void markDeleted(std::size_t index)                              { ops.at(index).reset(); }
+		bool isDeleted(std::size_t index) const                          { return ops.at(index) == nullptr; }
+		void replace(std::size_t index, std::unique_ptr<Operation>&& op) { ops.at(index) = std::move(op); }
+		// removes all tombstones in a single pass and returns the number of removed operations
+		std::size_t compact();
+		// all other functions (simulation, functionality construction, output, ...) require the circuit to be compact
+		bool isCompact() const { return std::none_of(ops.begin(), ops.end(), [](const auto& op) { return op == nullptr; }); }
+		// inserts every operation before the given position in a single pass (insertions at the same position keep their relative order)
+		void insert(std::vector<std::pair<std::size_t, std::unique_ptr<Operation>>>&& insertions);
+
 	};
 }
 #endif //INTERMEDIATEREPRESENTATION_QUANTUMCOMPUTATION_H
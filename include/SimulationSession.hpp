@@ -0,0 +1,102 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#ifndef INTERMEDIATEREPRESENTATION_SIMULATIONSESSION_H
+#define INTERMEDIATEREPRESENTATION_SIMULATIONSESSION_H
+
+#include "QuantumComputation.hpp"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace qc {
+	/**
+	 * Long-lived simulation of a state to which operations are applied one at a time (or batch-wise).
+	 *
+	 * The session owns its DD package together with the current state, the qubit mapping (changed by SWAPs) and the
+	 * variable order. In contrast to QuantumComputation::simulate, appending a few operations does not require to
+	 * simulate the whole circuit again. Qubit q always refers to the q-th circuit qubit, i.e., the mapping established
+	 * by SWAPs is taken into account by all queries.
+	 *
+	 * Garbage collection runs after every gcInterval applied operations (and after every batch). If a reordering
+	 * interval is set, the variable order is adapted according to the strategy after that many applied operations.
+	 * Reordering changes the variable order of all DDs of the package, i.e., checkpoints stay valid.
+	 */
+	class SimulationSession {
+	protected:
+		struct Checkpoint {
+			dd::Edge       state{};
+			permutationMap permutation{};
+			std::size_t    nops = 0;
+		};
+
+		std::unique_ptr<dd::Package>  dd;
+		unsigned short                nqubits = 0;
+		dd::Edge                      state{};
+		std::array<short, MAX_QUBITS> line{};
+		permutationMap                permutation{};
+		permutationMap                varMap{};
+		std::size_t                   nops = 0;
+		std::size_t                   sinceGC = 0;
+		std::size_t                   sinceReorder = 0;
+		std::vector<Checkpoint>       checkpoints{};
+
+		void multiply(const Operation& op);
+		void collectGarbage(bool force);
+		// qubit -> DD variable
+		permutationMap currentVariables() const;
+		void checkQubit(unsigned short q) const;
+
+	public:
+		dd::DynamicReorderingStrategy strategy        = dd::None;
+		std::size_t                   gcInterval      = 1; // 0 = only after batches
+		std::size_t                   reorderInterval = 0; // 0 = only on explicit calls to reorder
+
+		explicit SimulationSession(unsigned short nqubits, dd::DynamicReorderingStrategy strategy = dd::None);
+		~SimulationSession();
+
+		SimulationSession(const SimulationSession&) = delete;
+		SimulationSession& operator=(const SimulationSession&) = delete;
+
+		// discards the current state (but not the checkpoints) and starts over from |0...0> or the given state
+		void reset();
+		void reset(const dd::Edge& in);
+
+		// unitary operations are applied to the state, barriers, snapshots and probability outputs are ignored
+		void apply(const Operation& op);
+		void applyBatch(const std::vector<std::unique_ptr<Operation>>& ops);
+		void applyBatch(const QuantumComputation& qc);
+		template<class T, class... Args>
+		void emplace(Args&& ... args) {
+			apply(T(nqubits, std::forward<Args>(args)...));
+		}
+
+		// probability of measuring |1> on qubit q
+		fp probability(unsigned short q) const;
+		// joint distribution of the given qubits (see QuantumComputation::getMarginalProbabilities)
+		std::vector<fp> probabilities(const std::vector<unsigned short>& qubits) const;
+		// measurement samples of all qubits in the computational basis (bitstrings list qubit n-1 first)
+		std::map<std::string, std::size_t> sample(std::size_t shots, unsigned int nthreads = 1, std::uint64_t seed = 0) const;
+
+		// stores the current state and returns an identifier that can be used to return to it later on
+		std::size_t checkpoint();
+		void restore(std::size_t id);
+		void releaseCheckpoints();
+		std::size_t getNcheckpoints() const { return checkpoints.size(); }
+
+		// adapts the variable order according to the strategy
+		void reorder();
+
+		const dd::Edge& getState() const { return state; }
+		std::unique_ptr<dd::Package>& getPackage() { return dd; }
+		unsigned short getNqubits() const { return nqubits; }
+		std::size_t getNops() const { return nops; }
+		const permutationMap& getPermutation() const { return permutation; }
+		const permutationMap& getVarMap() const { return varMap; }
+	};
+}
+#endif //INTERMEDIATEREPRESENTATION_SIMULATIONSESSION_H
@@ -0,0 +1,101 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#ifndef INTERMEDIATEREPRESENTATION_STABILIZERSIMULATOR_H
+#define INTERMEDIATEREPRESENTATION_STABILIZERSIMULATOR_H
+
+#include "QuantumComputation.hpp"
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace qc {
+	/**
+	 * Simulates Clifford circuits on a stabilizer tableau (Aaronson and Gottesman, "Improved simulation of stabilizer circuits").
+	 *
+	 * Rows 0, ..., n-1 of the tableau hold the destabilizers, rows n, ..., 2n-1 the stabilizers and row 2n is used as
+	 * scratch space. The X and Z parts of every row are packed into 64-bit words, such that multiplying two rows (including
+	 * the computation of the resulting phase) as well as commutation checks process 64 qubits at once.
+	 * Gates take time linear and measurements time quadratic in the number of qubits.
+	 *
+	 * Supported are I, H, X, Y, Z, S, Sdag, V, Vdag, uncontrolled SWAPs, X, Y and Z gates with a single (positive or
+	 * negative) control, measurements, resets and the operations without effect on the state (barriers, snapshots, ...).
+	 * Pauli strings and bitstrings list qubit n-1 first and qubit 0 last.
+	 */
+	class StabilizerSimulator {
+	protected:
+		unsigned short             nqubits = 0;
+		std::size_t                nwords = 0;
+		std::vector<std::uint64_t> xs{};
+		std::vector<std::uint64_t> zs{};
+		std::vector<unsigned char> rs{};
+		std::mt19937_64            rng;
+
+		std::uint64_t* xrow(std::size_t row) { return &xs[row * nwords]; }
+		std::uint64_t* zrow(std::size_t row) { return &zs[row * nwords]; }
+		const std::uint64_t* xrow(std::size_t row) const { return &xs[row * nwords]; }
+		const std::uint64_t* zrow(std::size_t row) const { return &zs[row * nwords]; }
+		bool xbit(std::size_t row, unsigned short q) const { return (xrow(row)[q / 64] >> (q % 64)) & 1u; }
+		bool zbit(std::size_t row, unsigned short q) const { return (zrow(row)[q / 64] >> (q % 64)) & 1u; }
+
+		// row h := row i * row h
+		void rowsum(std::size_t h, std::size_t i);
+		void clearRow(std::size_t row);
+		void checkQubit(unsigned short q) const;
+		// returns the stabilizer row anticommuting with Z_q (or 2n if there is none)
+		std::size_t findRandomRow(unsigned short q) const;
+		// measures qubit q, where the given outcome is used in case the outcome is random
+		bool measure(unsigned short q, bool outcome);
+		// X and Z parts of a Pauli string (the phase is always +1)
+		void parsePauli(const std::string& pauli, std::vector<std::uint64_t>& px, std::vector<std::uint64_t>& pz) const;
+
+	public:
+		explicit StabilizerSimulator(unsigned short nqubits, std::uint64_t seed = 0);
+
+		// whether the operation (or every operation of the circuit) can be simulated on the tableau
+		static bool isClifford(const Operation& op);
+		static bool isClifford(const QuantumComputation& qc);
+
+		unsigned short getNqubits() const { return nqubits; }
+		// resets the state to |0...0>
+		void reset();
+		// copies the tableau of the other simulator (but not its random number generator)
+		void setState(const StabilizerSimulator& other);
+
+		void h(unsigned short q);
+		void s(unsigned short q);
+		void sdag(unsigned short q);
+		void x(unsigned short q);
+		void y(unsigned short q);
+		void z(unsigned short q);
+		void cx(unsigned short control, unsigned short target);
+		void cz(unsigned short a, unsigned short b);
+		void swap(unsigned short a, unsigned short b);
+
+		// measures qubit q in the computational basis (random outcomes are drawn from the internal generator)
+		bool measure(unsigned short q);
+		bool isDeterministic(unsigned short q) const;
+		void reset(unsigned short q);
+		// measures every qubit (without changing the state)
+		std::string measureAll();
+
+		// applies the operation, measurement outcomes are written to the classical bits
+		void apply(const Operation& op, std::vector<bool>& cbits);
+		// applies all operations of the circuit and returns the contents of the classical register
+		std::vector<bool> run(const QuantumComputation& qc);
+
+		// expectation value of a Pauli string over {I, X, Y, Z}, i.e., -1, 0 or 1
+		fp expectation(const std::string& pauli) const;
+		// samples all qubits of the current state
+		std::map<std::string, std::size_t> sample(std::size_t shots);
+
+		// state vector DD of the stabilizer state (variable q represents qubit q), the returned edge is not referenced
+		dd::Edge toDD(std::unique_ptr<dd::Package>& dd) const;
+	};
+}
+#endif //INTERMEDIATEREPRESENTATION_STABILIZERSIMULATOR_H
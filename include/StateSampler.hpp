@@ -0,0 +1,52 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#ifndef INTERMEDIATEREPRESENTATION_STATESAMPLER_H
+#define INTERMEDIATEREPRESENTATION_STATESAMPLER_H
+
+#include "QuantumComputation.hpp"
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace qc {
+	/**
+	 * Draws measurement samples (in the computational basis) from a state DD.
+	 *
+	 * On construction, the squared norms of all nodes are computed in a single pass over the DD and the resulting
+	 * branching probabilities are cached. Afterwards, every shot is drawn by a single walk from the root to the terminal.
+	 * Bitstrings list qubit n-1 first and qubit 0 last. Since simulate() restores the output permutation, qubit q refers
+	 * to the q-th output of the circuit and is represented by variable varMap[q] of the DD.
+	 * The sampler does not take ownership of the state, i.e., the state has to stay referenced while the sampler is used.
+	 */
+	class StateSampler {
+	protected:
+		dd::Edge                              root{};
+		unsigned short                        nqubits = 0;
+		std::vector<unsigned short>           qubitAt{}; // qubit represented by each variable
+		std::unordered_map<dd::NodePtr, fp>   probabilityOfOne{};
+		fp                                    norm = 0.;
+
+		fp computeNorm(const dd::Edge& e, std::unordered_map<dd::NodePtr, fp>& norms);
+
+	public:
+		StateSampler(const dd::Edge& state, unsigned short nqubits, const permutationMap& varMap = Operation::standardPermutation);
+
+		// squared norm of the state
+		fp getNorm() const { return norm; }
+		unsigned short getNqubits() const { return nqubits; }
+
+		// draws a single shot
+		std::string sample(std::mt19937_64& rng) const;
+		// draws the given number of shots using up to nthreads threads. Every thread uses its own random number generator
+		// derived from the seed and the thread index, i.e., the result is deterministic for a fixed seed and number of threads.
+		std::map<std::string, std::size_t> sample(std::size_t shots, unsigned int nthreads = 1, std::uint64_t seed = 0) const;
+	};
+}
+#endif //INTERMEDIATEREPRESENTATION_STATESAMPLER_H
@@ -0,0 +1,52 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#ifndef INTERMEDIATEREPRESENTATION_MITERBUILDER_H
+#define INTERMEDIATEREPRESENTATION_MITERBUILDER_H
+
+#include "QuantumComputation.hpp"
+
+namespace qc {
+	enum class MiterStrategy {
+		Naive,        // alternate between one gate of G and one inverted gate of G'
+		Proportional, // keep the fractions of applied gates of both circuits balanced
+		Lookahead     // apply whichever of the next two gates yields the smaller DD
+	};
+
+	/**
+	 * Constructs the miter G * G'^-1 of two circuits G and G' without building either functionality on its own.
+	 *
+	 * Starting from the identity, the gates of G are applied from the left and the inverted gates of G' from the right.
+	 * For equivalent circuits (and a suitable strategy) the intermediate DDs remain close to the identity.
+	 * Afterwards, the output permutations of both circuits are established on the respective side and garbage as well as
+	 * ancillary qubits are reduced. The circuits are equivalent (up to a global phase) iff the result equals the
+	 * identity subject to the same reductions.
+	 */
+	class MiterBuilder {
+	protected:
+		QuantumComputation& qc1;
+		QuantumComputation& qc2;
+		std::size_t         maxSize = 0;
+		dd::Edge            result{};
+		dd::Edge            reference{};
+
+		// applies the reductions of both circuits (the returned edge is referenced, e is released)
+		dd::Edge reduce(dd::Edge e, std::unique_ptr<dd::Package>& dd);
+
+	public:
+		MiterStrategy strategy = MiterStrategy::Proportional;
+
+		MiterBuilder(QuantumComputation& qc1, QuantumComputation& qc2);
+
+		// returns the (referenced) miter
+		dd::Edge build(std::unique_ptr<dd::Package>& dd);
+		// whether the previously built miter equals the (reduced) identity up to a global phase
+		bool isIdentity() const;
+
+		// maximum number of nodes of the intermediate DDs during the last construction
+		std::size_t getMaxSize() const { return maxSize; }
+	};
+}
+#endif //INTERMEDIATEREPRESENTATION_MITERBUILDER_H
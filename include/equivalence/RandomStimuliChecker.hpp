@@ -0,0 +1,77 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#ifndef INTERMEDIATEREPRESENTATION_RANDOMSTIMULICHECKER_H
+#define INTERMEDIATEREPRESENTATION_RANDOMSTIMULICHECKER_H
+
+#include "QuantumComputation.hpp"
+
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace qc {
+	enum class StimuliType {
+		Basis,   // random computational basis states
+		Product  // random single-qubit states on every qubit
+	};
+
+	struct RandomStimuliResult {
+		bool        equivalent  = true; // no counterexample has been found (which does not prove equivalence)
+		std::size_t simulations = 0;    // number of stimuli that have been simulated
+		fp          fidelity    = 1.;   // fidelity of the output states for the counterexample
+
+		// stimulus exposing the difference (only set if a counterexample has been found)
+		std::string                      basisState{};   // qubit n-1 first (basis stimuli)
+		std::vector<std::pair<fp, fp>>   productState{}; // (theta, phi) of cos(theta/2)|0> + e^(i phi) sin(theta/2)|1> for every qubit (product stimuli, (0, 0) for ancillae)
+	};
+
+	/**
+	 * Checks two circuits for equivalence by simulating both with identical random stimuli.
+	 *
+	 * Stimuli are given with respect to the logical qubits and the outputs are compared with respect to the output
+	 * permutations of the circuits (as done by QuantumComputation::simulate). Qubits that are ancillary in either circuit
+	 * always start in |0>. Two outputs are considered equal if their fidelity is at least 1 - tolerance, i.e., global
+	 * phases are ignored. If either circuit has garbage outputs, only the distributions of measuring all remaining outputs
+	 * are compared (by their classical fidelity), since the garbage outputs may be entangled with them. Several workers, each with its own package,
+	 * simulate stimuli in parallel until the first counterexample is found or the maximum number of simulations is reached.
+	 * Stimulus i is derived from the seed and i only, such that results are reproducible regardless of the number of workers.
+	 */
+	class RandomStimuliChecker {
+	public:
+		static constexpr fp DEFAULT_TOLERANCE = 1e-8;
+
+	protected:
+		QuantumComputation& qc1;
+		QuantumComputation& qc2;
+
+		// qubits that are ancillary (inputs) or garbage (outputs) in either circuit
+		std::bitset<MAX_QUBITS> ancillary() const { return qc1.ancillary | qc2.ancillary; }
+		std::bitset<MAX_QUBITS> garbage() const { return qc1.garbage | qc2.garbage; }
+
+		dd::Edge generateStimulus(std::size_t index, std::unique_ptr<dd::Package>& dd, RandomStimuliResult& stimulus) const;
+		// returns the fidelity of the outputs of both circuits for the given stimulus
+		fp check(std::size_t index, std::unique_ptr<dd::Package>& dd, RandomStimuliResult& stimulus) const;
+
+	public:
+		std::size_t   maxSimulations = 16;
+		unsigned int  nthreads       = 1;
+		std::uint64_t seed           = 0;
+		StimuliType   type           = StimuliType::Product;
+		fp            tolerance      = DEFAULT_TOLERANCE;
+
+		RandomStimuliChecker(QuantumComputation& qc1, QuantumComputation& qc2);
+
+		RandomStimuliResult run();
+
+		// |<x|y>|^2 for two state DDs
+		static fp fidelity(const dd::Edge& x, const dd::Edge& y);
+		// (sum_i sqrt(p_i q_i))^2 for two probability distributions
+		static fp fidelity(const std::vector<fp>& p, const std::vector<fp>& q);
+	};
+}
+#endif //INTERMEDIATEREPRESENTATION_RANDOMSTIMULICHECKER_H
@@ -65,6 +65,17 @@ namespace qc {
 			return op->getInverseDD2(dd, line, permutation, varMap);
 		}
 
+		std::unique_ptr<Operation> clone() const override {
+			auto nested = op->clone();
+			auto reg = controlRegister;
+			return std::make_unique<ClassicControlledOperation>(nested, reg, expectedValue);
+		}
+
+		void setNqubits(unsigned short nq) override {
+			nqubits = nq;
+			op->setNqubits(nq);
+		}
+
 		bool isUnitary() const override {
 			return false;
 		}
@@ -39,6 +39,15 @@ namespace qc {
 			}
 		}
 
+		std::unique_ptr<Operation> clone() const override {
+			auto op = std::make_unique<CompoundOperation>(nqubits);
+			op->copyAttributes(*this);
+			for (const auto& o: ops) {
+				op->ops.emplace_back(o->clone());
+			}
+			return op;
+		}
+
 		bool isCompoundOperation() const override {
 			return true;
 		}
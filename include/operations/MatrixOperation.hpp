@@ -0,0 +1,92 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#ifndef INTERMEDIATEREPRESENTATION_MATRIXOPERATION_H
+#define INTERMEDIATEREPRESENTATION_MATRIXOPERATION_H
+
+#include "CompoundOperation.hpp"
+#include "StandardOperation.hpp"
+
+#include <complex>
+
+namespace qc {
+	/**
+	 * Operation given by a dense unitary acting on a small number of qubits.
+	 *
+	 * Bit j of a row/column index of the (row-major) matrix corresponds to the j-th qubit in ascending order.
+	 * The decision diagram is constructed directly from the matrix instead of multiplying the DDs of individual gates.
+	 * If the operation has been created from a sequence of gates, these gates are kept and used whenever the
+	 * operation has to be exported (e.g., to OpenQASM), since the supported formats cannot represent arbitrary unitaries.
+	 */
+	class MatrixOperation : public CompoundOperation {
+	public:
+		static constexpr unsigned short MAX_MATRIX_QUBITS = 3;
+		using Matrix = std::vector<std::complex<fp>>;
+
+	protected:
+		std::vector<unsigned short> qubits{};
+		Matrix                      matrix{};
+
+		void setup(const std::vector<unsigned short>& qb);
+		dd::Edge buildDD(std::unique_ptr<dd::Package>& dd, const std::vector<short>& variables, bool inverse) const;
+		dd::Edge buildDD(std::unique_ptr<dd::Package>& dd, const std::vector<short>& blockIndex, dd::Edge ident, short lowest, short v, std::size_t row, std::size_t col, bool inverse) const;
+
+		// applies the operation to the (local) matrix m, i.e., computes op * m
+		static void apply(const StandardOperation& op, const std::vector<unsigned short>& qubits, Matrix& m);
+
+	public:
+		MatrixOperation(unsigned short nq, const std::vector<unsigned short>& qubits, const Matrix& matrix);
+		// ops have to be supported (see isSupported) and may only act on the given qubits
+		MatrixOperation(unsigned short nq, const std::vector<unsigned short>& qubits, std::vector<std::unique_ptr<Operation>>&& ops);
+
+		// operations that can be absorbed into a matrix operation
+		static bool isSupported(const Operation& op);
+
+		const std::vector<unsigned short>& getQubits() const { return qubits; }
+		const Matrix& getMatrix() const { return matrix; }
+
+		// the operation subsequently acts on qubit relabeling[q] instead of q (nested operations are not changed)
+		void relabelQubits(const std::vector<unsigned short>& relabeling);
+
+		// throws if the operation has not been created from a sequence of gates and, hence, cannot be exported
+		void checkExportable() const;
+
+		std::unique_ptr<Operation> clone() const override;
+
+		bool isNonUnitaryOperation() const override {
+			return false;
+		}
+
+		bool actsOn(unsigned short i) override {
+			return std::binary_search(qubits.begin(), qubits.end(), i);
+		}
+
+		dd::Edge getDD(std::unique_ptr<dd::Package>& dd, std::array<short, MAX_QUBITS>& line) const override;
+		dd::Edge getInverseDD(std::unique_ptr<dd::Package>& dd, std::array<short, MAX_QUBITS>& line) const override;
+		dd::Edge getDD(std::unique_ptr<dd::Package>& dd, std::array<short, MAX_QUBITS>& line, std::map<unsigned short, unsigned short>& permutation) const override;
+		dd::Edge getInverseDD(std::unique_ptr<dd::Package>& dd, std::array<short, MAX_QUBITS>& line, std::map<unsigned short, unsigned short>& permutation) const override;
+		dd::Edge getDD2(std::unique_ptr<dd::Package>& dd, std::array<short, MAX_QUBITS>& line, std::map<unsigned short, unsigned short>& permutation, std::map<unsigned short, unsigned short>& varMap) const override;
+		dd::Edge getInverseDD2(std::unique_ptr<dd::Package>& dd, std::array<short, MAX_QUBITS>& line, std::map<unsigned short, unsigned short>& permutation, std::map<unsigned short, unsigned short>& varMap) const override;
+
+		void dumpOpenQASM(std::ostream& of, const regnames_t& qreg, const regnames_t& creg) const override {
+			checkExportable();
+			CompoundOperation::dumpOpenQASM(of, qreg, creg);
+		}
+
+		void dumpReal(std::ostream& of) const override {
+			checkExportable();
+			CompoundOperation::dumpReal(of);
+		}
+
+		void dumpQiskit(std::ostream& of, const regnames_t& qreg, const regnames_t& creg, const char *anc_reg_name) const override {
+			checkExportable();
+			CompoundOperation::dumpQiskit(of, qreg, creg, anc_reg_name);
+		}
+
+		using CompoundOperation::print;
+		std::ostream& print(std::ostream& os, const std::map<unsigned short, unsigned short>& permutation) const override;
+	};
+}
+#endif //INTERMEDIATEREPRESENTATION_MATRIXOPERATION_H
@@ -43,6 +43,12 @@ namespace qc {
 			return getDD(dd, line);
 		}
 
+		std::unique_ptr<Operation> clone() const override {
+			auto op = std::make_unique<NonUnitaryOperation>(nqubits);
+			op->copyAttributes(*this);
+			return op;
+		}
+
 		bool isUnitary() const override {
 			return false;
 		}
@@ -34,7 +34,7 @@ namespace qc {
 
 	using regnames_t=std::vector<std::pair<std::string, std::string>>;
 	enum Format {
-		Real, OpenQASM, GRCS, Qiskit, TFC
+		Real, OpenQASM, GRCS, Qiskit, TFC, Binary
 	};	
 
 	struct Control {
@@ -123,6 +123,18 @@ namespace qc {
 					&& (end   == reg.size() -1 || reg[end].first != reg[end   + 1].first);
 		}
 
+		// copies the attributes common to all operations (used to implement clone)
+		void copyAttributes(const Operation& op) {
+			targets = op.targets;
+			controls = op.controls;
+			parameter = op.parameter;
+			nqubits = op.nqubits;
+			type = op.type;
+			multiTarget = op.multiTarget;
+			controlled = op.controlled;
+			std::copy(std::begin(op.name), std::end(op.name), std::begin(name));
+		}
+
 		static std::map<unsigned short, unsigned short> create_standard_permutation() {
 			std::map<unsigned short, unsigned short> permutation{};
 			for (unsigned short i=0; i < MAX_QUBITS; ++i)
@@ -140,6 +152,9 @@ namespace qc {
 		// Virtual Destructor
 		virtual ~Operation() = default;
 
+		// deep copy of the operation
+		virtual std::unique_ptr<Operation> clone() const = 0;
+
 		// Getters
 		const std::vector<unsigned short>& getTargets() const {
 			return targets;
@@ -89,6 +89,17 @@ namespace qc {
 			}
 		}
 
+		// maps an angle to the interval (-pi, pi]
+		static fp normalizeAngle(fp angle) {
+			angle = std::fmod(angle, 2*qc::PI);
+			if (angle <= -qc::PI) {
+				angle += 2*qc::PI;
+			} else if (angle > qc::PI) {
+				angle -= 2*qc::PI;
+			}
+			return angle;
+		}
+
 		static OpType parseU3(fp& lambda, fp& phi, fp& theta);
 		static OpType parseU2(fp& lambda, fp& phi);
 		static OpType parseU1(fp& lambda);
@@ -112,16 +123,28 @@ namespace qc {
 		StandardOperation(unsigned short nq, const std::vector<Control>& controls, unsigned short                     target, OpType g, fp lambda = 0, fp phi = 0, fp theta = 0);
 		StandardOperation(unsigned short nq, const std::vector<Control>& controls, const std::vector<unsigned short>& targets, OpType g, fp lambda = 0, fp phi = 0, fp theta = 0);
 
+		// Single-qubit gate given by its matrix (the global phase of the matrix is dropped)
+		StandardOperation(unsigned short nq, unsigned short target, const GateMatrix& matrix);
+
 		// MCT Constructor
 		StandardOperation(unsigned short nq, const std::vector<Control>& controls, unsigned short target);
 
 		// MCF (cSWAP) and Peres Constructor
 		StandardOperation(unsigned short nq, const std::vector<Control>& controls, unsigned short target0, unsigned short target1, OpType g);
 
+		std::unique_ptr<Operation> clone() const override {
+			auto op = std::make_unique<StandardOperation>();
+			op->copyAttributes(*this);
+			return op;
+		}
+
 		bool isStandardOperation() const override {
 			return true;
 		}
 
+		// matrix of the (single-qubit) gate applied to the target qubit
+		GateMatrix getGateMatrix(bool inverse = false) const;
+
 		dd::Edge getDD(std::unique_ptr<dd::Package>& dd, std::array<short, MAX_QUBITS>& line) const override;
 		dd::Edge getDD(std::unique_ptr<dd::Package>& dd, std::array<short, MAX_QUBITS>& line, std::map<unsigned short, unsigned short>& permutation) const override;
 
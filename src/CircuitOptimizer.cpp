@@ -6,43 +6,49 @@
 #include "CircuitOptimizer.hpp"
 
 namespace qc {
+	constexpr std::size_t CircuitOptimizer::DEFAULT_CANCELLATION_WINDOW;
+	constexpr std::size_t CircuitOptimizer::FAST_CANCELLATION_WINDOW;
+	constexpr std::size_t CircuitOptimizer::DEFAULT_SCHEDULING_LOOKAHEAD;
 
 	void CircuitOptimizer::removeIdentities(QuantumComputation& qc) {
-		// delete the identities from circuit
-		auto it=qc.ops.begin();
-		while(it != qc.ops.end()) {
-			if ((*it)->isStandardOperation()) {
-				if ((*it)->getType() == I) {
-					it = qc.ops.erase(it);
-				} else {
-					++it;
-				}
-			} else {
-				++it;
+		// mark the identities as deleted and remove them from the circuit in a single pass
+		for (std::size_t i = 0; i < qc.ops.size(); ++i) {
+			const auto& op = qc.ops[i];
+			if (op != nullptr && op->isStandardOperation() && op->getType() == I) {
+				qc.markDeleted(i);
 			}
 		}
+		qc.compact();
 	}
 
+	void CircuitOptimizer::removeIdentities(DAG& dag) {
+		for (const auto node: dag) {
+			const auto& op = dag.at(node);
+			if (op.isStandardOperation() && op.getType() == I) {
+				dag.remove(node);
+			}
+		}
+	}
 
 	void CircuitOptimizer::swapGateFusion(QuantumComputation& qc) {
-		// print incoming circuit
-		//qc.print(std::cout );
-		//std::cout << std::endl;
-		unsigned short highest_physical_qubit = 0;
-		for (const auto& q: qc.initialLayout) {
-			if (q.first > highest_physical_qubit)
-				highest_physical_qubit = q.first;
-		}
+		DAG dag(qc);
+		swapGateFusion(dag);
+		removeIdentities(qc);
+	}
 
-		auto dag = DAG(highest_physical_qubit + 1);
+	bool CircuitOptimizer::isCNOT(const Operation& op) {
+		return op.isStandardOperation() && op.getType() == X && op.getNcontrols() == 1 && op.getControls().at(0).type == Control::pos;
+	}
 
-		for (auto & it : qc.ops) {
-			if (!it->isUnitary()) {
+	void CircuitOptimizer::swapGateFusion(DAG& dag) {
+		for (const auto node: dag) {
+			auto& op = dag.at(node);
+			if (!op.isUnitary()) {
 				std::cerr << "Non unitary operation detected. This is currently not supported. Proceed with caution!" << std::endl;
 				continue;
 			}
-			if(!it->isStandardOperation()) {
-				if (it->isCompoundOperation()) {
+			if(!op.isStandardOperation()) {
+				if (op.isCompoundOperation()) {
 					std::cerr << "Compound operation detected. This is currently not supported. Proceed with caution!" << std::endl;
 					return;
 				} else {
@@ -51,214 +57,774 @@ namespace qc {
 			}
 
 			// Operation is not a CNOT
-			if (it->getType() != X || it->getNcontrols() != 1 || it->getControls().at(0).type != Control::pos) {
-				addToDag(dag, &it);
+			if (!isCNOT(op)) {
+				continue;
+			}
+
+			unsigned short control = op.getControls().at(0).qubit;
+			unsigned short target = op.getTargets().at(0);
+
+			// previous operation has to act on both, the control and the target qubit
+			auto prevNode = dag.predecessor(node, control);
+			if (prevNode == DAG::NONE || prevNode != dag.predecessor(node, target)) {
+				continue;
+			}
+
+			// previous operation is not a CNOT
+			auto& prev = dag.at(prevNode);
+			if (!prev.isStandardOperation() || !isCNOT(prev)) {
+				continue;
+			}
+
+			auto prevControl = prev.getControls().at(0).qubit;
+			auto prevTarget = prev.getTargets().at(0);
+
+			if (control == prevControl && target == prevTarget) {
+				// elimination
+				dag.remove(prevNode);
+				dag.remove(node);
+			} else if (control == prevTarget && target == prevControl) {
+				// replace with SWAP + CNOT (both act on the same qubits as before, so the DAG stays valid)
+				prev.setGate(SWAP);
+				prev.setTargets({target, control});
+				prev.setControls({});
+
+				op.setTargets({control});
+				op.setControls({Control(target)});
+			}
+		}
+	}
+
+	DAG CircuitOptimizer::constructDAG(QuantumComputation& qc) {
+		DAG dag(qc);
+		dag.print(std::cout);
+		return dag;
+	}
+
+	void CircuitOptimizer::singleGateFusion(QuantumComputation& qc, bool numeric) {
+		DAG dag(qc);
+		singleGateFusion(dag, numeric);
+		removeIdentities(qc);
+	}
+
+	GateMatrix CircuitOptimizer::multiply(const GateMatrix& a, const GateMatrix& b) {
+		GateMatrix result{};
+		for (std::size_t row = 0; row < 2; ++row) {
+			for (std::size_t col = 0; col < 2; ++col) {
+				auto& r = result[2*row + col];
+				r = complex_zero;
+				for (std::size_t k = 0; k < 2; ++k) {
+					const auto& x = a[2*row + k];
+					const auto& y = b[2*k + col];
+					r.r += x.r * y.r - x.i * y.i;
+					r.i += x.r * y.i + x.i * y.r;
+				}
+			}
+		}
+		return result;
+	}
+
+	void CircuitOptimizer::singleGateFusion(DAG& dag, bool numeric) {
+		auto isSingleQubitGate = [](const Operation& op) {
+			return op.getControls().empty() && op.getTargets().size() == 1;
+		};
+
+		for (const auto node: dag) {
+			const auto& op = dag.at(node);
+			// non-unitary and classic-controlled operations are kept "as-is"
+			if (!op.isStandardOperation() && !op.isCompoundOperation()) {
+				continue;
+			}
+
+			// compound operations are kept "as-is"
+			// not a single qubit operation
+			if (op.isCompoundOperation() || !isSingleQubitGate(op)) {
 				continue;
 			}
 
-			unsigned short control = it->getControls().at(0).qubit;
-			unsigned short target = it->getTargets().at(0);
+			auto target = op.getTargets().at(0);
 
 			// first operation
-			if (dag.at(control).empty() || dag.at(target).empty()) {
-				addToDag(dag, &it);
+			auto prevNode = dag.predecessor(node, target);
+			if (prevNode == DAG::NONE) {
 				continue;
 			}
 
-			auto opC = dag.at(control).front();
-			auto opT = dag.at(target).front();
+			// no single qubit op to fuse with operation to fuse with
+			auto& prev = dag.at(prevNode);
+			if (!prev.isCompoundOperation() && (!prev.isStandardOperation() || !isSingleQubitGate(prev))) {
+				continue;
+			}
+			// the matrix of a matrix operation cannot be extended
+			if (dynamic_cast<const MatrixOperation*>(&prev) != nullptr) {
+				continue;
+			}
 
-			// previous operation is not a CNOT
-			if ((*opC)->getType() != qc::X || (*opC)->getNcontrols() != 1 || (*opC)->getControls().at(0).type != Control::pos ||
-			(*opT)->getType() != qc::X || (*opT)->getNcontrols() != 1 || (*opT)->getControls().at(0).type != Control::pos) {
-				addToDag(dag, &it);
+			if (numeric) {
+				if (prev.isCompoundOperation()) {
+					continue;
+				}
+				const auto& prevOp = dynamic_cast<const StandardOperation&>(prev);
+				const auto& curOp = dynamic_cast<const StandardOperation&>(op);
+				auto fused = std::make_unique<StandardOperation>(op.getNqubits(), target, multiply(curOp.getGateMatrix(), prevOp.getGateMatrix()));
+				if (fused->getType() == I) {
+					dag.remove(prevNode);
+				} else {
+					dag.replace(prevNode, std::move(fused));
+				}
+				dag.remove(node);
 				continue;
 			}
 
-			auto opCcontrol = (*opC)->getControls().at(0).qubit;
-			auto opCtarget = (*opC)->getTargets().at(0);
-			auto opTcontrol = (*opT)->getControls().at(0).qubit;
-			auto opTtarget = (*opT)->getTargets().at(0);
+			// compound operation
+			if (prev.isCompoundOperation()) {
+				auto& compop = dynamic_cast<CompoundOperation&>(prev);
+				auto lastop = (--(compop.end()));
+
+				// compound operation does contain non single-qubit gates
+				if (!isSingleQubitGate(**lastop)) {
+					continue;
+				}
 
-			// operation at control and target qubit are not the same
-			if (opCcontrol != opTcontrol || opCtarget != opTtarget) {
-				addToDag(dag, &it);
+				compop.emplace_back<StandardOperation>(
+						op.getNqubits(),
+						op.getTargets().at(0),
+						op.getType(),
+						op.getParameter().at(0),
+						op.getParameter().at(1),
+						op.getParameter().at(2));
+				dag.remove(node);
 				continue;
 			}
 
-			if (control == opCcontrol && target == opCtarget) {
-				// elimination
-				dag.at(control).pop_front();
-				dag.at(target).pop_front();
-				(*opC)->setGate(I);
-				(*opC)->setControls({});
-				it->setGate(I);
-				it->setControls({});
-			} else if (control == opCtarget && target == opCcontrol) {
-				dag.at(control).pop_front();
-				dag.at(target).pop_front();
-
-				// replace with SWAP + CNOT
-				(*opC)->setGate(SWAP);
-				(*opC)->setTargets({target, control});
-				(*opC)->setControls({});
-				addToDag(dag, opC);
-
-				it->setTargets({control});
-				it->setControls({Control(target)});
-				addToDag(dag, &it);
-			} else {
-				addToDag(dag, &it);
+			// single qubit op
+			auto compop = std::make_unique<CompoundOperation>(op.getNqubits());
+			compop->emplace_back<StandardOperation>(
+					prev.getNqubits(),
+					prev.getTargets().at(0),
+					prev.getType(),
+					prev.getParameter().at(0),
+					prev.getParameter().at(1),
+					prev.getParameter().at(2));
+			compop->emplace_back<StandardOperation>(
+					op.getNqubits(),
+					op.getTargets().at(0),
+					op.getType(),
+					op.getParameter().at(0),
+					op.getParameter().at(1),
+					op.getParameter().at(2));
+			dag.replace(prevNode, std::move(compop));
+			dag.remove(node);
+		}
+	}
+
+	CircuitOptimizer::Basis CircuitOptimizer::basisOf(const Operation& op, unsigned short qubit) {
+		for (const auto& c: op.getControls()) {
+			if (c.qubit == qubit) {
+				return Basis::Z;
+			}
+		}
+		for (const auto& t: op.getTargets()) {
+			if (t != qubit) {
+				continue;
+			}
+			switch (op.getType()) {
+				case I:
+					return Basis::Identity;
+				case Z:
+				case S:
+				case Sdag:
+				case T:
+				case Tdag:
+				case U1:
+				case RZ:
+					return Basis::Z;
+				case X:
+				case RX:
+				case V:
+				case Vdag:
+					return Basis::X;
+				default:
+					return Basis::None;
 			}
 		}
+		return Basis::Identity;
+	}
+
+	bool CircuitOptimizer::commute(const Operation& a, const Operation& b) {
+		if (!a.isStandardOperation() || !b.isStandardOperation()) {
+			return false;
+		}
 
-		removeIdentities(qc);
+		auto commuteOn = [&a, &b](unsigned short qubit) {
+			const auto ba = basisOf(a, qubit);
+			const auto bb = basisOf(b, qubit);
+			if (ba == Basis::Identity || bb == Basis::Identity) {
+				return true;
+			}
+			return ba == bb && ba != Basis::None;
+		};
 
-		// print resulting circuit
-		//qc.print(std::cout );
+		for (const auto& c: a.getControls()) {
+			if (!commuteOn(c.qubit)) {
+				return false;
+			}
+		}
+		for (const auto& t: a.getTargets()) {
+			if (!commuteOn(t)) {
+				return false;
+			}
+		}
+		return true;
 	}
 
-	DAG CircuitOptimizer::constructDAG(QuantumComputation& qc) {
-		unsigned short highest_physical_qubit = 0;
-		for (const auto& q: qc.initialLayout) {
-			if (q.first > highest_physical_qubit)
-				highest_physical_qubit = q.first;
+	bool CircuitOptimizer::isInverse(const Operation& a, const Operation& b) {
+		if (!a.isStandardOperation() || !b.isStandardOperation()) {
+			return false;
+		}
+
+		// controls have to coincide (order does not matter)
+		if (a.getNcontrols() != b.getNcontrols()) {
+			return false;
+		}
+		for (const auto& c: a.getControls()) {
+			if (std::none_of(b.getControls().begin(), b.getControls().end(), [&c](const Control& d) { return c.qubit == d.qubit && c.type == d.type; })) {
+				return false;
+			}
 		}
 
-		auto dag = DAG(highest_physical_qubit + 1);
+		const auto& ta = a.getTargets();
+		const auto& tb = b.getTargets();
+		const auto& pa = a.getParameter();
+		const auto& pb = b.getParameter();
+		auto equal = [](fp x, fp y) { return std::abs(x - y) < PARAMETER_TOLERANCE; };
+
+		switch (a.getType()) {
+			case SWAP:
+				return b.getType() == SWAP && tb.size() == 2 && ((ta[0] == tb[0] && ta[1] == tb[1]) || (ta[0] == tb[1] && ta[1] == tb[0]));
+			case iSWAP:
+			case P:
+			case Pdag:
+				return false;
+			default:
+				break;
+		}
 
-		for (auto & it : qc.ops) {
-			if (!it->isUnitary()) {
-				std::cerr << "Non unitary operation detected. This is currently not supported. Proceed with caution!" << std::endl;
+		if (ta != tb) {
+			return false;
+		}
+
+		switch (a.getType()) {
+			case H:
+			case X:
+			case Y:
+			case Z:
+				return b.getType() == a.getType();
+			case S:    return b.getType() == Sdag;
+			case Sdag: return b.getType() == S;
+			case T:    return b.getType() == Tdag;
+			case Tdag: return b.getType() == T;
+			case V:    return b.getType() == Vdag;
+			case Vdag: return b.getType() == V;
+			case U1:
+			case RX:
+			case RY:
+			case RZ:
+				return b.getType() == a.getType() && equal(pa[0], -pb[0]);
+			case U3:
+				// U3(theta, phi, lambda)^-1 = U3(-theta, -lambda, -phi)
+				return b.getType() == U3 && equal(pa[2], -pb[2]) && equal(pa[1], -pb[0]) && equal(pa[0], -pb[1]);
+			default:
+				return false;
+		}
+	}
+
+	void CircuitOptimizer::cancelInverseGates(QuantumComputation& qc, std::size_t window) {
+		DAG dag(qc);
+		cancelInverseGates(dag, window);
+		qc.compact();
+	}
+
+	void CircuitOptimizer::cancelInverseGates(DAG& dag, std::size_t window) {
+		for (const auto node: dag) {
+			const auto& op = dag.at(node);
+			if (!op.isStandardOperation() || op.getType() == I) {
 				continue;
 			}
-			addToDag(dag, &it);
-		}
 
-		bool allEmpty = false;
-		while (!allEmpty) {
-			allEmpty = true;
-			for (int i = 0; i < qc.nqubits + qc.nancillae; ++i) {
-				if(!dag.at(i).empty()) {
-					allEmpty = false;
-					for (const auto& c: dag.at(i).front()->get()->getControls()){
-						std::cout << c.qubit;
+			const auto wires = dag.getWires(node);
+			const auto wire = wires.front();
+
+			// search backwards along the first qubit of the operation for an inverse gate
+			auto candidate = dag.predecessor(node, wire);
+			for (std::size_t steps = 0; candidate != DAG::NONE && steps < window; ++steps) {
+				const auto& prev = dag.at(candidate);
+				if (isInverse(prev, op)) {
+					// every gate in between (on any of the qubits) has to commute with the operation
+					bool cancellable = true;
+					for (const auto w: wires) {
+						auto between = dag.predecessor(node, w);
+						while (between != candidate && between != DAG::NONE && cancellable) {
+							cancellable = commute(dag.at(between), op);
+							between = dag.predecessor(between, w);
+						}
+						if (between != candidate) {
+							cancellable = false;
+						}
+						if (!cancellable) {
+							break;
+						}
 					}
-					for (const auto& t: dag.at(i).front()->get()->getTargets()){
-						std::cout << t;
+					if (cancellable) {
+						dag.remove(candidate);
+						dag.remove(node);
 					}
-					std::cout << dag.at(i).front()->get()->getName();
-					dag.at(i).pop_front();
-					std::cout << "\t";
-				} else {
-					std::cout << "\t\t";
+					break;
 				}
+
+				if (!commute(prev, op)) {
+					break;
+				}
+				candidate = dag.predecessor(candidate, wire);
 			}
-			std::cout << std::endl;
 		}
-		return dag;
 	}
 
-	void CircuitOptimizer::addToDag(DAG& dag, std::unique_ptr<Operation> *op) {
-		for (const auto& control: (*op)->getControls()) {
-			dag.at(control.qubit).push_front(op);
-		}
-		for (const auto& target: (*op)->getTargets()) {
-			dag.at(target).push_front(op);
-		}
+	void CircuitOptimizer::consolidateBlocks(QuantumComputation& qc, unsigned short maxBlockQubits) {
+		DAG dag(qc);
+		consolidateBlocks(dag, maxBlockQubits);
+		dag.compact();
 	}
 
-	void CircuitOptimizer::singleGateFusion(QuantumComputation& qc) {
-		unsigned short highest_physical_qubit = 0;
-		for (const auto& q: qc.initialLayout) {
-			if (q.first > highest_physical_qubit)
-				highest_physical_qubit = q.first;
+	void CircuitOptimizer::consolidateBlocks(DAG& dag, unsigned short maxBlockQubits) {
+		if (maxBlockQubits == 0 || maxBlockQubits > MatrixOperation::MAX_MATRIX_QUBITS) {
+			throw QFRException("[consolidateBlocks] Blocks have to act on 1 to " + std::to_string(MatrixOperation::MAX_MATRIX_QUBITS) + " qubits");
 		}
 
-		auto dag = DAG(highest_physical_qubit + 1);
-
-		for (auto & it : qc.ops) {
-			if (!it->isStandardOperation() && !it->isCompoundOperation()) {
-				throw QFRException("Unexpected operation encountered");
+		struct Block {
+			std::vector<unsigned short> qubits{};
+			std::vector<std::size_t>    ops{};
+			bool                        merged = false;
+		};
+		constexpr std::size_t NONE = std::numeric_limits<std::size_t>::max();
+
+		std::vector<Block> blocks{};
+		// block that is currently open on each qubit
+		std::vector<std::size_t> open(MAX_QUBITS, NONE);
+		auto close = [&blocks, &open](std::size_t b) {
+			for (const auto q: blocks[b].qubits) {
+				open[q] = NONE;
+			}
+		};
+
+		// blocks refer to their operations by the position in the topological order
+		std::vector<DAG::NodeId> order{};
+		order.reserve(dag.size());
+		std::vector<unsigned short> used{};
+		std::vector<std::size_t> adjacent{};
+		for (const auto node: dag) {
+			const auto& op = dag.at(node);
+			const auto i = order.size();
+			order.emplace_back(node);
+			// operations other than standard operations act as a barrier for all blocks
+			if (!op.isStandardOperation()) {
+				std::fill(open.begin(), open.end(), NONE);
+				continue;
 			}
 
-			// compound operations are added "as-is"
-			if (it->isCompoundOperation()) {
-				for (int i = 0; i < it->getNqubits(); ++i) {
-					if (it->actsOn(i)) {
-						dag.at(i).push_front(&it);
+			used.clear();
+			for (const auto& c: op.getControls()) {
+				used.emplace_back(c.qubit);
+			}
+			used.insert(used.end(), op.getTargets().begin(), op.getTargets().end());
+			std::sort(used.begin(), used.end());
+			used.erase(std::unique(used.begin(), used.end()), used.end());
+
+			if (!MatrixOperation::isSupported(op) || used.size() > maxBlockQubits) {
+				for (const auto q: used) {
+					if (open[q] != NONE) {
+						close(open[q]);
 					}
 				}
 				continue;
 			}
 
-			// not a single qubit operation
-			if (!it->getControls().empty() || it->getTargets().size() > 1) {
-				addToDag(dag, &it);
+			adjacent.clear();
+			auto qubits = used;
+			for (const auto q: used) {
+				const auto b = open[q];
+				if (b != NONE && std::find(adjacent.begin(), adjacent.end(), b) == adjacent.end()) {
+					adjacent.emplace_back(b);
+					qubits.insert(qubits.end(), blocks[b].qubits.begin(), blocks[b].qubits.end());
+				}
+			}
+			std::sort(qubits.begin(), qubits.end());
+			qubits.erase(std::unique(qubits.begin(), qubits.end()), qubits.end());
+
+			std::size_t target = NONE;
+			if (qubits.size() <= maxBlockQubits && !adjacent.empty()) {
+				// extend the first adjacent block by all others and the current operation
+				target = adjacent.front();
+				auto& block = blocks[target];
+				for (auto it = adjacent.begin() + 1; it != adjacent.end(); ++it) {
+					auto& other = blocks[*it];
+					const auto mid = block.ops.size();
+					block.ops.insert(block.ops.end(), other.ops.begin(), other.ops.end());
+					std::inplace_merge(block.ops.begin(), block.ops.begin() + static_cast<std::ptrdiff_t>(mid), block.ops.end());
+					other.merged = true;
+				}
+				block.qubits = qubits;
+				block.ops.emplace_back(i);
+			} else {
+				for (const auto b: adjacent) {
+					close(b);
+				}
+				target = blocks.size();
+				blocks.emplace_back();
+				blocks.back().qubits = used;
+				blocks.back().ops.emplace_back(i);
+			}
+			for (const auto q: blocks[target].qubits) {
+				open[q] = target;
+			}
+		}
+
+		// every block is placed at the position of its last operation
+		for (auto& block: blocks) {
+			if (block.merged || block.ops.size() < 2) {
 				continue;
 			}
+			const auto nq = dag.at(order[block.ops.front()]).getNqubits();
+			std::vector<std::unique_ptr<Operation>> ops{};
+			ops.reserve(block.ops.size());
+			for (const auto i: block.ops) {
+				ops.emplace_back(dag.extract(order[i]));
+			}
+			dag.insertAfter(order[block.ops.back()], std::make_unique<MatrixOperation>(nq, block.qubits, std::move(ops)));
+		}
+	}
+	bool CircuitOptimizer::phaseOf(const Operation& op, fp& lambda) {
+		if (!op.isStandardOperation() || !op.getControls().empty() || op.getTargets().size() != 1) {
+			return false;
+		}
+		switch (op.getType()) {
+			case Z:    lambda = qc::PI;      return true;
+			case S:    lambda = qc::PI_2;    return true;
+			case Sdag: lambda = -qc::PI_2;   return true;
+			case T:    lambda = qc::PI_4;    return true;
+			case Tdag: lambda = -qc::PI_4;   return true;
+			case U1:
+			case RZ:
+				lambda = op.getParameter().at(0);
+				return true;
+			default:
+				return false;
+		}
+	}
 
-			auto target = it->getTargets().at(0);
+	void CircuitOptimizer::mergeRotations(QuantumComputation& qc) {
+		DAG dag(qc);
+		mergeRotations(dag);
+		qc.compact();
+	}
 
-			// first operation
-			if (dag.at(target).empty()) {
-				addToDag(dag, &it);
+	void CircuitOptimizer::mergeRotations(DAG& dag) {
+		// the value of a qubit is the XOR of a set of variables (sorted) and possibly negated.
+		// a new variable is introduced whenever a qubit (re-)enters a region.
+		using Parity = std::pair<std::vector<std::size_t>, bool>;
+		struct Term {
+			DAG::NodeId              first;
+			fp                       lambda;
+			std::vector<DAG::NodeId> others{};
+		};
+		std::map<Parity, Term> terms{};
+
+		std::size_t nvars = 0;
+		std::vector<Parity> parity(MAX_QUBITS);
+		// every region is identified by one of its qubits
+		std::vector<std::size_t> region(MAX_QUBITS);
+		std::vector<std::vector<unsigned short>> members(MAX_QUBITS);
+		for (unsigned short q = 0; q < MAX_QUBITS; ++q) {
+			parity[q] = {{nvars++}, false};
+			region[q] = q;
+			members[q] = {q};
+		}
+
+		auto close = [&](unsigned short qubit) {
+			const auto r = region[qubit];
+			const auto qubits = std::move(members[r]);
+			for (const auto q: qubits) {
+				parity[q] = {{nvars++}, false};
+				region[q] = q;
+				members[q] = {q};
+			}
+		};
+		auto join = [&](unsigned short a, unsigned short b) {
+			auto ra = region[a];
+			auto rb = region[b];
+			if (ra == rb) {
+				return;
+			}
+			if (members[ra].size() < members[rb].size()) {
+				std::swap(ra, rb);
+			}
+			for (const auto q: members[rb]) {
+				region[q] = ra;
+			}
+			members[ra].insert(members[ra].end(), members[rb].begin(), members[rb].end());
+			members[rb].clear();
+		};
+
+		std::vector<std::size_t> sum{};
+		for (const auto node: dag) {
+			const auto& op = dag.at(node);
+			// operations other than standard operations end all regions
+			if (!op.isStandardOperation()) {
+				for (unsigned short q = 0; q < MAX_QUBITS; ++q) {
+					parity[q] = {{nvars++}, false};
+					region[q] = q;
+					members[q] = {q};
+				}
 				continue;
 			}
 
-			auto dagQubit = dag.at(target);
-			auto op = dagQubit.front();
+			const auto& targets = op.getTargets();
+			const auto& controls = op.getControls();
+			fp lambda = 0;
+			if (phaseOf(op, lambda)) {
+				auto it = terms.find(parity[targets[0]]);
+				if (it == terms.end()) {
+					terms.emplace(parity[targets[0]], Term{node, lambda});
+				} else {
+					it->second.lambda += lambda;
+					it->second.others.emplace_back(node);
+				}
+			} else if (op.getType() == I) {
+				continue;
+			} else if (op.getType() == X && controls.empty()) {
+				parity[targets[0]].second = !parity[targets[0]].second;
+			} else if (op.getType() == X && controls.size() == 1 && controls[0].type == Control::pos) {
+				const auto c = controls[0].qubit;
+				const auto t = targets[0];
+				join(c, t);
+				sum.clear();
+				std::set_symmetric_difference(parity[t].first.begin(), parity[t].first.end(),
+				                              parity[c].first.begin(), parity[c].first.end(), std::back_inserter(sum));
+				parity[t].first.swap(sum);
+				parity[t].second = parity[t].second != parity[c].second;
+			} else if (op.getType() == SWAP && controls.empty()) {
+				join(targets[0], targets[1]);
+				std::swap(parity[targets[0]], parity[targets[1]]);
+			} else {
+				for (const auto& c: controls) {
+					close(c.qubit);
+				}
+				for (const auto t: targets) {
+					close(t);
+				}
+			}
+		}
 
-			// no single qubit op to fuse with operation to fuse with
-			if (!(*op)->isCompoundOperation() && (!(*op)->getControls().empty() || (*op)->getTargets().size() > 1)) {
-				addToDag(dag, &it);
+		// the merged rotation replaces the first occurrence of its parity
+		for (auto& entry: terms) {
+			auto& term = entry.second;
+			if (term.others.empty()) {
 				continue;
 			}
+			const auto& first = dag.at(term.first);
+			auto merged = std::make_unique<StandardOperation>(first.getNqubits(), first.getTargets().at(0), U1, std::remainder(term.lambda, 2*qc::PI));
+			if (merged->getType() == I) {
+				dag.remove(term.first);
+			} else {
+				dag.replace(term.first, std::move(merged));
+			}
+			for (const auto node: term.others) {
+				dag.remove(node);
+			}
+		}
+	}
+	void CircuitOptimizer::relabel(Operation& op, const std::vector<unsigned short>& relabeling) {
+		if (op.isCompoundOperation()) {
+			auto& compop = dynamic_cast<CompoundOperation&>(op);
+			for (auto& o: compop) {
+				relabel(*o, relabeling);
+			}
+			if (auto* matrixOp = dynamic_cast<MatrixOperation*>(&op)) {
+				matrixOp->relabelQubits(relabeling);
+			}
+			return;
+		}
+		if (op.isClassicControlledOperation()) {
+			relabel(*dynamic_cast<ClassicControlledOperation&>(op).getOperation(), relabeling);
+			return;
+		}
 
-			// compound operation
-			if ((*op)->isCompoundOperation()) {
-				auto compop = dynamic_cast<CompoundOperation*>(op->get());
-				auto lastop = (--(compop->end()));
+		auto controls = op.getControls();
+		for (auto& c: controls) {
+			c.qubit = relabeling.at(c.qubit);
+		}
+		op.setControls(controls);
+		// the targets of a measurement are classical bits
+		if (op.getType() != Measure) {
+			auto targets = op.getTargets();
+			for (auto& t: targets) {
+				t = relabeling.at(t);
+			}
+			op.setTargets(targets);
+		}
+	}
 
-				// compound operation does contain non single-qubit gates
-				if (!(*lastop)->getControls().empty() || (*lastop)->getTargets().size() > 1) {
-					addToDag(dag, &it);
-					continue;
-				}
+	void CircuitOptimizer::eliminateSwaps(QuantumComputation& qc) {
+		DAG dag(qc);
+		eliminateSwaps(dag);
+		dag.compact();
+	}
 
-				compop->emplace_back<StandardOperation>(
-						it->getNqubits(),
-						it->getTargets().at(0),
-						it->getType(),
-						it->getParameter().at(0),
-						it->getParameter().at(1),
-						it->getParameter().at(2));
-				it->setGate(I);
+	void CircuitOptimizer::eliminateSwaps(DAG& dag) {
+		// CNOT(a, b) CNOT(b, a) CNOT(a, b) = SWAP(a, b)
+		for (const auto node: dag) {
+			const auto& op = dag.at(node);
+			if (!isCNOT(op)) {
+				continue;
+			}
+			const auto a = op.getControls().at(0).qubit;
+			const auto b = op.getTargets().at(0);
+			const auto second = dag.successor(node, a);
+			if (second == DAG::NONE || second != dag.successor(node, b)) {
+				continue;
+			}
+			const auto& op2 = dag.at(second);
+			if (!isCNOT(op2) || op2.getControls().at(0).qubit != b || op2.getTargets().at(0) != a) {
+				continue;
+			}
+			const auto third = dag.successor(second, a);
+			if (third == DAG::NONE || third != dag.successor(second, b)) {
+				continue;
+			}
+			const auto& op3 = dag.at(third);
+			if (!isCNOT(op3) || op3.getControls().at(0).qubit != a || op3.getTargets().at(0) != b) {
 				continue;
 			}
+			dag.replace(node, std::make_unique<StandardOperation>(op.getNqubits(), std::vector<Control>{}, a, b, SWAP));
+			dag.remove(second);
+			dag.remove(third);
+		}
 
-			// single qubit op
-			auto compop = std::make_unique<CompoundOperation>(it->getNqubits());
-			compop->emplace_back<StandardOperation>(
-					(*op)->getNqubits(),
-					(*op)->getTargets().at(0),
-					(*op)->getType(),
-					(*op)->getParameter().at(0),
-					(*op)->getParameter().at(1),
-					(*op)->getParameter().at(2));
-			compop->emplace_back<StandardOperation>(
-					it->getNqubits(),
-					it->getTargets().at(0),
-					it->getType(),
-					it->getParameter().at(0),
-					it->getParameter().at(1),
-					it->getParameter().at(2));
-			it->setGate(I);
-			(*op) = std::move(compop);
-			dag.at(target).push_front(op);
+		// the contents of (original) qubit q reside on qubit relabeling[q] of the new circuit
+		std::vector<unsigned short> relabeling(MAX_QUBITS);
+		std::iota(relabeling.begin(), relabeling.end(), 0);
+		for (const auto node: dag) {
+			auto& op = dag.at(node);
+			if (op.isStandardOperation() && op.getType() == SWAP && op.getControls().empty()) {
+				std::swap(relabeling.at(op.getTargets().at(0)), relabeling.at(op.getTargets().at(1)));
+				dag.remove(node);
+				continue;
+			}
+			if (op.getType() == Snapshot || op.getType() == ShowProbabilities) {
+				// these operations depend on the order of the qubits, hence, the permutation is established explicitly
+				std::vector<unsigned short> inverse(MAX_QUBITS);
+				for (unsigned short q = 0; q < MAX_QUBITS; ++q) {
+					inverse[relabeling[q]] = q;
+				}
+				for (unsigned short q = 0; q < MAX_QUBITS; ++q) {
+					const auto w = relabeling[q];
+					if (w == q) {
+						continue;
+					}
+					dag.insertBefore(node, std::make_unique<StandardOperation>(op.getNqubits(), std::vector<Control>{}, q, w, SWAP));
+					// the contents of qubit q (belonging to inverse[q]) moved to w
+					const auto p = inverse[q];
+					relabeling[p] = w;
+					inverse[w] = p;
+					relabeling[q] = q;
+					inverse[q] = q;
+				}
+			} else {
+				relabel(op, relabeling);
+			}
 		}
+		// the operations now act on other wires
+		dag.relink();
 
-		removeIdentities(qc);
+		auto& qc = dag.getCircuit();
+		permutationMap outputPermutation{};
+		for (const auto& entry: qc.outputPermutation) {
+			outputPermutation[relabeling.at(entry.first)] = entry.second;
+		}
+		qc.outputPermutation = outputPermutation;
 	}
+	void CircuitOptimizer::scheduleForDDSize(QuantumComputation& qc, std::unique_ptr<dd::Package>& dd, std::size_t lookahead) {
+		if (qc.getNqubits() == 0) {
+			return;
+		}
 
+		DAG dag(qc);
+		// an operation is ready if it commutes with all pending operations preceding it on any of its wires
+		auto isReady = [&dag, lookahead](DAG::NodeId node) {
+			const auto& op = dag.at(node);
+			for (const auto w: dag.getWires(node)) {
+				std::size_t steps = 0;
+				for (auto other = dag.front(w); other != node; other = dag.successor(other, w)) {
+					if (++steps > lookahead || !commute(dag.at(other), op)) {
+						return false;
+					}
+				}
+			}
+			return true;
+		};
+
+		std::array<short, MAX_QUBITS> line{};
+		line.fill(LINE_DEFAULT);
+		permutationMap map = qc.initialLayout;
+		dd->setMode(dd::Matrix);
+		dd::Edge e = qc.createInitialMatrix(dd);
+
+		std::vector<std::unique_ptr<Operation>> scheduled{};
+		scheduled.reserve(dag.size());
+		std::vector<DAG::NodeId> candidates{};
+		while (dag.size() > 0) {
+			// the first pending operation is always ready
+			candidates.assign(1, *dag.begin());
+			for (std::size_t w = 0; w < dag.getNwires(); ++w) {
+				auto node = dag.front(static_cast<unsigned short>(w));
+				for (std::size_t steps = 0; node != DAG::NONE && steps <= lookahead; ++steps) {
+					if (std::find(candidates.begin(), candidates.end(), node) == candidates.end() && isReady(node)) {
+						candidates.emplace_back(node);
+					}
+					node = dag.successor(node, static_cast<unsigned short>(w));
+				}
+			}
+			// ties are broken in favor of the original order
+			std::sort(candidates.begin(), candidates.end());
+
+			auto best = DAG::NONE;
+			dd::Edge bestEdge = e;
+			permutationMap bestMap{};
+			auto bestSize = std::numeric_limits<unsigned int>::max();
+			for (const auto node: candidates) {
+				const auto& op = dag.at(node);
+				auto candidateMap = map;
+				// non-unitary operations do not contribute to the functionality
+				const auto candidate = op.isUnitary() ? dd->multiply(op.getDD(dd, line, candidateMap), e) : e;
+				const auto size = dd->size(candidate);
+				if (size < bestSize) {
+					best = node;
+					bestEdge = candidate;
+					bestMap = std::move(candidateMap);
+					bestSize = size;
+				}
+			}
+
+			dd->incRef(bestEdge);
+			dd->decRef(e);
+			e = bestEdge;
+			map = std::move(bestMap);
+			dd->garbageCollect();
+
+			scheduled.emplace_back(std::move(qc.ops[best]));
+			dag.remove(best);
+		}
+		dd->decRef(e);
+		qc.ops = std::move(scheduled);
+	}
 }
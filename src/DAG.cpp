@@ -0,0 +1,368 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#include "DAG.hpp"
+
+namespace qc {
+	constexpr DAG::NodeId DAG::NONE;
+
+	DAG::DAG(QuantumComputation& qc): qc(&qc) {
+		build();
+	}
+
+	void DAG::collectWires(const Operation& op, std::vector<unsigned short>& result) const {
+		if (op.isCompoundOperation()) {
+			const auto& compop = dynamic_cast<const CompoundOperation&>(op);
+			for (const auto& o: compop) {
+				collectWires(*o, result);
+			}
+			// matrix operations additionally carry the qubits they act on as targets
+			for (const auto& t: op.getTargets())
+				result.emplace_back(t);
+			return;
+		}
+
+		if (op.isClassicControlledOperation()) {
+			const auto& ccop = dynamic_cast<const ClassicControlledOperation&>(op);
+			collectWires(*ccop.getOperation(), result);
+			const auto reg = ccop.getControlRegister();
+			for (unsigned short i = 0; i < reg.second; ++i) {
+				result.emplace_back(static_cast<unsigned short>(nqubits + reg.first + i));
+			}
+			return;
+		}
+
+		switch (op.getType()) {
+			case Measure:
+				for (const auto& c: op.getControls())
+					result.emplace_back(c.qubit);
+				for (const auto& t: op.getTargets())
+					result.emplace_back(static_cast<unsigned short>(nqubits + t));
+				break;
+			case ShowProbabilities:
+				// depends on the whole quantum state
+				for (unsigned short q = 0; q < nqubits; ++q)
+					result.emplace_back(q);
+				break;
+			default:
+				for (const auto& c: op.getControls())
+					result.emplace_back(c.qubit);
+				for (const auto& t: op.getTargets())
+					result.emplace_back(t);
+				break;
+		}
+	}
+
+	std::vector<unsigned short> DAG::wiresOf(const Operation& op) const {
+		std::vector<unsigned short> result{};
+		collectWires(op, result);
+		std::sort(result.begin(), result.end());
+		result.erase(std::unique(result.begin(), result.end()), result.end());
+		if (!result.empty() && result.back() >= nwires) {
+			throw QFRException("[DAG] Operation acts on wire " + std::to_string(result.back()) + " which does not exist in the circuit");
+		}
+		return result;
+	}
+
+	void DAG::build() {
+		nqubits = qc->getNqubits();
+		if (!qc->initialLayout.empty()) {
+			nqubits = std::max<std::size_t>(nqubits, qc->initialLayout.rbegin()->first + 1u);
+		}
+		nwires = nqubits + qc->getNcbits();
+
+		nbuilt = qc->getNops();
+		inserted.clear();
+		removed.assign(nbuilt, false);
+		nremoved = 0;
+		next.resize(nbuilt);
+		prev.resize(nbuilt);
+		for (NodeId node = 0; node < nbuilt; ++node) {
+			next[node] = node + 1 < nbuilt ? node + 1 : NONE;
+			prev[node] = node > 0 ? node - 1 : NONE;
+			if (*(qc->begin() + static_cast<std::ptrdiff_t>(node)) == nullptr) {
+				removed[node] = true;
+				++nremoved;
+			}
+		}
+		head = nbuilt > 0 ? 0 : NONE;
+		tail = nbuilt > 0 ? nbuilt - 1 : NONE;
+		relink();
+	}
+
+	void DAG::relink() {
+		const auto nnodes = removed.size();
+		offsets.assign(1, 0);
+		offsets.reserve(nnodes + 1);
+		wires.clear();
+		wires.reserve(2*nnodes);
+		first.assign(nwires, NONE);
+		last.assign(nwires, NONE);
+
+		for (NodeId node = 0; node < nnodes; ++node) {
+			if (!removed[node]) {
+				const auto opWires = wiresOf(at(node));
+				wires.insert(wires.end(), opWires.begin(), opWires.end());
+			}
+			offsets.emplace_back(wires.size());
+		}
+
+		preds.assign(wires.size(), NONE);
+		succs.assign(wires.size(), NONE);
+		for (auto node = head; node != NONE; node = next[node]) {
+			for (auto s = offsets[node]; s < offsets[node+1]; ++s) {
+				const auto wire = wires[s];
+				const auto pred = last[wire];
+				preds[s] = pred;
+				if (pred == NONE) {
+					first[wire] = node;
+				} else {
+					succs[slot(pred, wire)] = node;
+				}
+				last[wire] = node;
+			}
+		}
+	}
+
+	std::size_t DAG::slot(NodeId node, unsigned short wire) const {
+		for (auto s = offsets.at(node); s < offsets[node+1]; ++s) {
+			if (wires[s] == wire) {
+				return s;
+			}
+		}
+		throw QFRException("[DAG] Node " + std::to_string(node) + " does not act on wire " + std::to_string(wire));
+	}
+
+	bool DAG::actsOn(NodeId node, unsigned short wire) const {
+		const auto begin = wires.begin() + static_cast<std::ptrdiff_t>(offsets[node]);
+		const auto end = wires.begin() + static_cast<std::ptrdiff_t>(offsets[node+1]);
+		return std::binary_search(begin, end, wire);
+	}
+
+	std::unique_ptr<Operation>& DAG::operationOf(NodeId node) {
+		if (node >= nbuilt) {
+			return inserted[node - nbuilt];
+		}
+		return *(qc->begin() + static_cast<std::ptrdiff_t>(node));
+	}
+
+	Operation& DAG::at(NodeId node) const {
+		if (removed.at(node)) {
+			throw QFRException("[DAG] Node " + std::to_string(node) + " has been removed");
+		}
+		if (node >= nbuilt) {
+			return *inserted[node - nbuilt];
+		}
+		return **(qc->begin() + static_cast<std::ptrdiff_t>(node));
+	}
+
+	std::vector<unsigned short> DAG::getWires(NodeId node) const {
+		return std::vector<unsigned short>(wires.begin() + static_cast<std::ptrdiff_t>(offsets.at(node)), wires.begin() + static_cast<std::ptrdiff_t>(offsets[node+1]));
+	}
+
+	std::vector<DAG::NodeId> DAG::predecessors(NodeId node) const {
+		std::vector<NodeId> result{};
+		for (auto s = offsets.at(node); s < offsets[node+1]; ++s) {
+			if (preds[s] != NONE && std::find(result.begin(), result.end(), preds[s]) == result.end()) {
+				result.emplace_back(preds[s]);
+			}
+		}
+		return result;
+	}
+
+	std::vector<DAG::NodeId> DAG::successors(NodeId node) const {
+		std::vector<NodeId> result{};
+		for (auto s = offsets.at(node); s < offsets[node+1]; ++s) {
+			if (succs[s] != NONE && std::find(result.begin(), result.end(), succs[s]) == result.end()) {
+				result.emplace_back(succs[s]);
+			}
+		}
+		return result;
+	}
+
+	void DAG::unlink(NodeId node) {
+		for (auto s = offsets[node]; s < offsets[node+1]; ++s) {
+			const auto wire = wires[s];
+			const auto pred = preds[s];
+			const auto succ = succs[s];
+			if (pred == NONE) {
+				first[wire] = succ;
+			} else {
+				succs[slot(pred, wire)] = succ;
+			}
+			if (succ == NONE) {
+				last[wire] = pred;
+			} else {
+				preds[slot(succ, wire)] = pred;
+			}
+			preds[s] = NONE;
+			succs[s] = NONE;
+		}
+		removed[node] = true;
+		++nremoved;
+	}
+
+	void DAG::remove(NodeId node) {
+		if (removed.at(node)) {
+			return;
+		}
+		unlink(node);
+		operationOf(node).reset();
+	}
+
+	std::unique_ptr<Operation> DAG::extract(NodeId node) {
+		if (removed.at(node)) {
+			throw QFRException("[DAG] Node " + std::to_string(node) + " has been removed");
+		}
+		unlink(node);
+		return std::move(operationOf(node));
+	}
+
+	void DAG::replace(NodeId node, std::unique_ptr<Operation>&& op) {
+		if (removed.at(node)) {
+			throw QFRException("[DAG] Node " + std::to_string(node) + " has been removed");
+		}
+		if (wiresOf(*op) != getWires(node)) {
+			throw QFRException("[DAG] Replacement of node " + std::to_string(node) + " does not act on the same wires");
+		}
+		operationOf(node) = std::move(op);
+	}
+
+	DAG::NodeId DAG::insertBefore(NodeId node, std::unique_ptr<Operation>&& op) {
+		if (node == NONE) {
+			return insert(tail, std::move(op));
+		}
+		return insert(prev.at(node), std::move(op));
+	}
+
+	DAG::NodeId DAG::insertAfter(NodeId node, std::unique_ptr<Operation>&& op) {
+		if (node == NONE || node >= removed.size()) {
+			throw QFRException("[DAG] Cannot insert after non-existing node");
+		}
+		return insert(node, std::move(op));
+	}
+
+	DAG::NodeId DAG::insert(NodeId after, std::unique_ptr<Operation>&& op) {
+		const auto opWires = wiresOf(*op);
+		const NodeId node = removed.size();
+
+		// the circuit gets an empty slot such that node ids keep coinciding with the positions in the circuit
+		qc->insert(qc->end(), std::unique_ptr<Operation>{});
+		inserted.emplace_back(std::move(op));
+		removed.emplace_back(false);
+
+		// position in the topological order
+		next.emplace_back(after == NONE ? head : next[after]);
+		prev.emplace_back(after);
+		if (after == NONE) {
+			head = node;
+		} else {
+			next[after] = node;
+		}
+		if (next[node] == NONE) {
+			tail = node;
+		} else {
+			prev[next[node]] = node;
+		}
+
+		// the predecessor on every wire is the closest preceding node acting on it
+		std::vector<NodeId> opPreds(opWires.size(), NONE);
+		std::size_t nfound = 0;
+		if (next[node] == NONE) {
+			for (std::size_t i = 0; i < opWires.size(); ++i) {
+				opPreds[i] = last[opWires[i]];
+			}
+			nfound = opWires.size();
+		}
+		for (auto other = after; other != NONE && nfound < opWires.size(); other = prev[other]) {
+			if (removed[other]) {
+				continue;
+			}
+			for (std::size_t i = 0; i < opWires.size(); ++i) {
+				if (opPreds[i] == NONE && actsOn(other, opWires[i])) {
+					opPreds[i] = other;
+					++nfound;
+				}
+			}
+		}
+
+		wires.insert(wires.end(), opWires.begin(), opWires.end());
+		offsets.emplace_back(wires.size());
+		preds.insert(preds.end(), opPreds.begin(), opPreds.end());
+		succs.resize(wires.size(), NONE);
+		for (auto s = offsets[node]; s < offsets[node+1]; ++s) {
+			const auto wire = wires[s];
+			const auto pred = preds[s];
+			const auto succ = pred == NONE ? first[wire] : succs[slot(pred, wire)];
+			succs[s] = succ;
+			if (pred == NONE) {
+				first[wire] = node;
+			} else {
+				succs[slot(pred, wire)] = node;
+			}
+			if (succ == NONE) {
+				last[wire] = node;
+			} else {
+				preds[slot(succ, wire)] = node;
+			}
+		}
+		return node;
+	}
+
+	void DAG::compact() {
+		// every inserted operation is placed directly before the closest succeeding node that stems from the circuit
+		std::vector<std::pair<std::size_t, std::unique_ptr<Operation>>> insertions{};
+		auto position = nbuilt;
+		for (auto node = tail; node != NONE; node = prev[node]) {
+			if (node < nbuilt) {
+				position = node;
+			} else if (!removed[node]) {
+				insertions.emplace_back(position, std::move(inserted[node - nbuilt]));
+			}
+		}
+		std::reverse(insertions.begin(), insertions.end());
+		qc->insert(std::move(insertions));
+		qc->compact();
+		build();
+	}
+
+	std::vector<std::vector<DAG::NodeId>> DAG::layers() const {
+		std::vector<std::vector<NodeId>> result{};
+		std::vector<std::size_t> layer(removed.size(), 0);
+		for (const auto node: *this) {
+			std::size_t l = 0;
+			for (auto s = offsets[node]; s < offsets[node+1]; ++s) {
+				if (preds[s] != NONE) {
+					l = std::max(l, layer[preds[s]] + 1);
+				}
+			}
+			layer[node] = l;
+			if (l >= result.size()) {
+				result.resize(l+1);
+			}
+			result[l].emplace_back(node);
+		}
+		return result;
+	}
+
+	std::ostream& DAG::print(std::ostream& os) const {
+		const auto ls = layers();
+		for (std::size_t l = 0; l < ls.size(); ++l) {
+			os << std::setw(4) << l << ":";
+			for (const auto node: ls[l]) {
+				const auto& op = at(node);
+				os << "\t" << op.getName() << "(";
+				const auto w = getWires(node);
+				for (std::size_t i = 0; i < w.size(); ++i) {
+					if (i > 0) os << ",";
+					os << w[i];
+				}
+				os << ")";
+			}
+			os << "\n";
+		}
+		return os;
+	}
+}
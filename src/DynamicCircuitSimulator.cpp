@@ -0,0 +1,216 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#include "DynamicCircuitSimulator.hpp"
+
+namespace qc {
+	DynamicCircuitSimulator::DynamicCircuitSimulator(QuantumComputation& qc, std::unique_ptr<dd::Package>& dd, std::uint64_t seed): qc(qc), dd(dd), rng(seed) {
+		line.fill(LINE_DEFAULT);
+		compile();
+	}
+
+	void DynamicCircuitSimulator::compile() {
+		steps.clear();
+		for (const auto& op: qc) {
+			switch (op->getType()) {
+				case Barrier:
+				case Snapshot:
+				case ShowProbabilities:
+					break;
+				case Measure:
+					// the i-th qubit is measured into the i-th classical bit
+					for (std::size_t i = 0; i < op->getControls().size(); ++i) {
+						steps.push_back({Step::Measure, op.get(), op->getControls()[i].qubit, op->getTargets().at(i)});
+					}
+					break;
+				case Reset:
+					for (const auto q: op->getTargets()) {
+						steps.push_back({Step::Reset, op.get(), q, 0});
+					}
+					break;
+				default:
+					if (op->isNonUnitaryOperation()) {
+						throw QFRException("[DynamicCircuitSimulator] Operation " + std::string(op->getName()) + " is not supported");
+					}
+					steps.push_back({Step::Apply, op.get(), 0, 0});
+					break;
+			}
+		}
+	}
+
+	bool DynamicCircuitSimulator::conditionHolds(const Operation& op, const std::vector<bool>& cbits) const {
+		if (!op.isClassicControlledOperation()) {
+			return true;
+		}
+		const auto& ccop = dynamic_cast<const ClassicControlledOperation&>(op);
+		const auto reg = ccop.getControlRegister();
+		unsigned long long value = 0;
+		for (unsigned short i = 0; i < reg.second; ++i) {
+			if (cbits.at(reg.first + i)) {
+				value |= 1ull << i;
+			}
+		}
+		return value == ccop.getExpectedValue();
+	}
+
+	fp DynamicCircuitSimulator::probabilityOfOne(const dd::Edge& e, const permutationMap& map, unsigned short qubit) const {
+		const auto probabilities = QuantumComputation::getMarginalProbabilities(e, {qubit}, map);
+		const auto norm = probabilities[0] + probabilities[1];
+		if (norm < dd::ComplexNumbers::TOLERANCE) {
+			throw QFRException("[DynamicCircuitSimulator] Cannot measure the zero vector");
+		}
+		return probabilities[1] / norm;
+	}
+
+	dd::Edge DynamicCircuitSimulator::collapse(const dd::Edge& e, const permutationMap& map, unsigned short qubit, bool outcome, fp probability) {
+		const GateMatrix projector = outcome ? GateMatrix{complex_zero, complex_zero, complex_zero, complex_one}
+		                                     : GateMatrix{complex_one, complex_zero, complex_zero, complex_zero};
+		line[map.at(qubit)] = LINE_TARGET;
+		auto result = dd->multiply(dd->makeGateDD(projector, qc.getNqubits(), line), e);
+		line[map.at(qubit)] = LINE_DEFAULT;
+
+		const auto factor = 1. / std::sqrt(probability);
+		result.w = dd->cn.lookup(CN::val(result.w.r) * factor, CN::val(result.w.i) * factor);
+		dd->incRef(result);
+		return result;
+	}
+
+	dd::Edge DynamicCircuitSimulator::applyX(dd::Edge e, const permutationMap& map, unsigned short qubit) {
+		line[map.at(qubit)] = LINE_TARGET;
+		auto result = dd->multiply(dd->makeGateDD(Xmat, qc.getNqubits(), line), e);
+		line[map.at(qubit)] = LINE_DEFAULT;
+		dd->incRef(result);
+		dd->decRef(e);
+		return result;
+	}
+
+	void DynamicCircuitSimulator::explore(std::size_t step, dd::Edge e, permutationMap map, std::vector<bool> cbits, fp probability, std::size_t shots,
+	                                      bool exhaustive, fp threshold, bool keepStates, std::vector<Branch>& branches) {
+		for (; step < steps.size(); ++step) {
+			const auto& s = steps[step];
+			if (s.kind == Step::Apply) {
+				if (!conditionHolds(*s.op, cbits)) {
+					continue;
+				}
+				auto tmp = dd->multiply(s.op->getDD(dd, line, map), e);
+				dd->incRef(tmp);
+				dd->decRef(e);
+				e = tmp;
+				dd->garbageCollect();
+				continue;
+			}
+
+			const auto p1 = probabilityOfOne(e, map, s.qubit);
+			const std::array<fp, 2> p{1. - p1, p1};
+			std::array<std::size_t, 2> n{0, 0};
+			if (!exhaustive) {
+				n[1] = std::binomial_distribution<std::size_t>(shots, p1)(rng);
+				n[0] = shots - n[1];
+			}
+
+			// collapse all followed outcomes before releasing the current state
+			std::array<dd::Edge, 2> children{};
+			std::array<bool, 2> follow{};
+			for (std::size_t k = 0; k < 2; ++k) {
+				follow[k] = exhaustive ? (probability * p[k] > threshold && p[k] > dd::ComplexNumbers::TOLERANCE) : (n[k] > 0);
+				if (follow[k]) {
+					children[k] = collapse(e, map, s.qubit, k == 1, p[k]);
+				}
+			}
+			dd->decRef(e);
+
+			for (std::size_t k = 0; k < 2; ++k) {
+				if (!follow[k]) {
+					continue;
+				}
+				auto childBits = cbits;
+				auto child = children[k];
+				if (s.kind == Step::Measure) {
+					childBits.at(s.bit) = (k == 1);
+				} else if (k == 1) {
+					child = applyX(child, map, s.qubit);
+				}
+				explore(step + 1, child, map, std::move(childBits), probability * p[k], n[k], exhaustive, threshold, keepStates, branches);
+			}
+			return;
+		}
+
+		// correct permutation if necessary
+		qc.changePermutation(e, map, qc.outputPermutation, line, dd);
+		e = qc.reduceAncillae(e, dd);
+
+		Branch branch{};
+		branch.classical.assign(cbits.size(), '0');
+		for (std::size_t i = 0; i < cbits.size(); ++i) {
+			if (cbits[i]) {
+				branch.classical[cbits.size() - 1 - i] = '1';
+			}
+		}
+		branch.probability = probability;
+		branch.shots = shots;
+		if (keepStates) {
+			branch.state = e;
+		} else {
+			dd->decRef(e);
+			branch.state = dd::Package::DDzero;
+		}
+		branches.emplace_back(std::move(branch));
+	}
+
+	DynamicCircuitSimulator::Branch DynamicCircuitSimulator::simulateShot(const dd::Edge& in) {
+		dd->setMode(dd::Vector);
+		auto e = in;
+		dd->incRef(e);
+		std::vector<Branch> branches{};
+		explore(0, e, qc.initialLayout, std::vector<bool>(qc.getNcbits(), false), 1., 1, false, 0., true, branches);
+		return branches.front();
+	}
+
+	std::map<std::string, std::size_t> DynamicCircuitSimulator::sampleTrajectories(const dd::Edge& in, std::size_t shots) {
+		dd->setMode(dd::Vector);
+		std::map<std::string, std::size_t> counts{};
+		std::vector<Branch> branches{};
+		for (std::size_t i = 0; i < shots; ++i) {
+			branches.clear();
+			auto e = in;
+			dd->incRef(e);
+			explore(0, e, qc.initialLayout, std::vector<bool>(qc.getNcbits(), false), 1., 1, false, 0., false, branches);
+			++counts[branches.front().classical];
+		}
+		return counts;
+	}
+
+	std::map<std::string, std::size_t> DynamicCircuitSimulator::sampleBranching(const dd::Edge& in, std::size_t shots) {
+		std::map<std::string, std::size_t> counts{};
+		if (shots == 0) {
+			return counts;
+		}
+		dd->setMode(dd::Vector);
+		auto e = in;
+		dd->incRef(e);
+		std::vector<Branch> branches{};
+		explore(0, e, qc.initialLayout, std::vector<bool>(qc.getNcbits(), false), 1., shots, false, 0., false, branches);
+		for (const auto& branch: branches) {
+			counts[branch.classical] += branch.shots;
+		}
+		return counts;
+	}
+
+	std::vector<DynamicCircuitSimulator::Branch> DynamicCircuitSimulator::simulateBranches(const dd::Edge& in, fp threshold) {
+		dd->setMode(dd::Vector);
+		auto e = in;
+		dd->incRef(e);
+		std::vector<Branch> branches{};
+		explore(0, e, qc.initialLayout, std::vector<bool>(qc.getNcbits(), false), 1., 0, true, threshold, true, branches);
+		return branches;
+	}
+
+	void DynamicCircuitSimulator::releaseBranches(std::unique_ptr<dd::Package>& dd, std::vector<Branch>& branches) {
+		for (auto& branch: branches) {
+			dd->decRef(branch.state);
+		}
+		branches.clear();
+	}
+}
@@ -0,0 +1,146 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#include "FunctionalityCheckpoints.hpp"
+
+namespace qc {
+	dd::Edge FunctionalityCheckpoints::build(std::size_t interval, bool storeSuffixes) {
+		if (interval == 0) {
+			throw QFRException("[FunctionalityCheckpoints] Checkpoint interval has to be positive");
+		}
+		clear();
+		if (qc.getNqubits() == 0)
+			return dd->DDone;
+
+		std::array<short, MAX_QUBITS> line{};
+		line.fill(LINE_DEFAULT);
+		permutationMap map = qc.initialLayout;
+		dd->setMode(dd::Matrix);
+		dd::Edge e = qc.createInitialMatrix(dd);
+
+		for (std::size_t i = 0; i < qc.getNops(); ++i) {
+			if (i % interval == 0) {
+				dd->incRef(e);
+				prefixes.push_back({i, e, map});
+			}
+			auto tmp = dd->multiply(operation(i).getDD(dd, line, map), e);
+
+			dd->incRef(tmp);
+			dd->decRef(e);
+			e = tmp;
+
+			dd->garbageCollect();
+		}
+		if (prefixes.empty()) {
+			dd->incRef(e);
+			prefixes.push_back({0, e, map});
+		}
+		nops = qc.getNops();
+		finalMap = map;
+
+		if (storeSuffixes) {
+			// products of the operations from every checkpoint position to the end (computed back to front)
+			dd::Edge suffix = dd->makeIdent(0, static_cast<short>(qc.getNqubits() - 1));
+			dd->incRef(suffix);
+			std::size_t end = qc.getNops();
+			for (auto it = prefixes.rbegin(); it != prefixes.rend(); ++it) {
+				auto chunkMap = it->map;
+				dd::Edge chunk = dd->makeIdent(0, static_cast<short>(qc.getNqubits() - 1));
+				dd->incRef(chunk);
+				for (std::size_t i = it->position; i < end; ++i) {
+					auto tmp = dd->multiply(operation(i).getDD(dd, line, chunkMap), chunk);
+					dd->incRef(tmp);
+					dd->decRef(chunk);
+					chunk = tmp;
+				}
+				auto tmp = dd->multiply(suffix, chunk);
+				dd->incRef(tmp);
+				dd->decRef(chunk);
+				dd->decRef(suffix);
+				suffix = tmp;
+				dd->garbageCollect();
+
+				dd->incRef(suffix);
+				suffixes.push_back({it->position, suffix, it->map});
+				end = it->position;
+			}
+			dd->decRef(suffix);
+			std::reverse(suffixes.begin(), suffixes.end());
+		}
+
+		// correct permutation if necessary
+		QuantumComputation::changePermutation(e, map, qc.outputPermutation, line, dd);
+		e = qc.reduceAncillae(e, dd);
+
+		return e;
+	}
+
+	dd::Edge FunctionalityCheckpoints::rebuild(std::size_t editBegin, std::size_t editEnd) {
+		if (prefixes.empty()) {
+			throw QFRException("[FunctionalityCheckpoints] No checkpoints available. Call build first.");
+		}
+		if (editBegin > editEnd || editEnd > qc.getNops() || qc.getNops() - editEnd > nops || editBegin > nops) {
+			throw QFRException("[FunctionalityCheckpoints] Invalid edit range [" + std::to_string(editBegin) + ", " + std::to_string(editEnd) + ")");
+		}
+
+		// last prefix checkpoint not affected by the edit
+		const auto prefix = std::upper_bound(prefixes.begin(), prefixes.end(), editBegin,
+		                                     [](std::size_t pos, const Checkpoint& c) { return pos < c.position; }) - 1;
+
+		std::array<short, MAX_QUBITS> line{};
+		line.fill(LINE_DEFAULT);
+		permutationMap map = prefix->map;
+		dd->setMode(dd::Matrix);
+		dd::Edge e = prefix->e;
+		dd->incRef(e);
+
+		// position in the base circuit = position in the edited circuit + shift (for operations after the edit)
+		const auto shift = static_cast<std::ptrdiff_t>(nops) - static_cast<std::ptrdiff_t>(qc.getNops());
+		auto suffix = suffixes.begin();
+		for (std::size_t i = prefix->position; i < qc.getNops(); ++i) {
+			if (i >= editEnd && suffix != suffixes.end()) {
+				const auto basePosition = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(i) + shift);
+				while (suffix != suffixes.end() && suffix->position < basePosition) {
+					++suffix;
+				}
+				if (suffix != suffixes.end() && suffix->position == basePosition && suffix->map == map) {
+					auto tmp = dd->multiply(suffix->e, e);
+					dd->incRef(tmp);
+					dd->decRef(e);
+					e = tmp;
+					map = finalMap;
+					break;
+				}
+			}
+
+			auto tmp = dd->multiply(operation(i).getDD(dd, line, map), e);
+
+			dd->incRef(tmp);
+			dd->decRef(e);
+			e = tmp;
+
+			dd->garbageCollect();
+		}
+
+		// correct permutation if necessary
+		QuantumComputation::changePermutation(e, map, qc.outputPermutation, line, dd);
+		e = qc.reduceAncillae(e, dd);
+
+		return e;
+	}
+
+	void FunctionalityCheckpoints::clear() {
+		for (auto& checkpoint: prefixes) {
+			dd->decRef(checkpoint.e);
+		}
+		for (auto& checkpoint: suffixes) {
+			dd->decRef(checkpoint.e);
+		}
+		prefixes.clear();
+		suffixes.clear();
+		nops = 0;
+		finalMap.clear();
+	}
+}
@@ -0,0 +1,177 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#include "PassManager.hpp"
+
+namespace qc {
+	constexpr std::size_t PassManager::DEFAULT_MAX_ITERATIONS;
+
+	namespace {
+		unsigned long long countOps(const Operation& op) {
+			// the gates within a matrix operation are only kept for exporting the circuit
+			if (op.isCompoundOperation() && dynamic_cast<const MatrixOperation*>(&op) == nullptr) {
+				unsigned long long count = 0;
+				for (const auto& o: dynamic_cast<const CompoundOperation&>(op)) {
+					count += countOps(*o);
+				}
+				return count;
+			}
+			return 1;
+		}
+
+		unsigned long long countMultiQubitOps(const Operation& op) {
+			if (const auto* matrixOp = dynamic_cast<const MatrixOperation*>(&op)) {
+				return matrixOp->getQubits().size() >= 2 ? 1 : 0;
+			}
+			if (op.isCompoundOperation()) {
+				unsigned long long count = 0;
+				for (const auto& o: dynamic_cast<const CompoundOperation&>(op)) {
+					count += countMultiQubitOps(*o);
+				}
+				return count;
+			}
+			if (op.isClassicControlledOperation()) {
+				return countMultiQubitOps(*dynamic_cast<const ClassicControlledOperation&>(op).getOperation());
+			}
+			if (!op.isStandardOperation()) {
+				return 0;
+			}
+			return (op.getNcontrols() + op.getNtargets() >= 2) ? 1 : 0;
+		}
+
+		std::string escapeJSON(const std::string& s) {
+			std::string result{};
+			for (const auto c: s) {
+				if (c == '"' || c == '\\') {
+					result += '\\';
+				}
+				result += c;
+			}
+			return result;
+		}
+	}
+
+	CircuitMetrics CircuitMetrics::of(QuantumComputation& qc) {
+		return of(DAG(qc));
+	}
+
+	CircuitMetrics CircuitMetrics::of(const DAG& dag) {
+		CircuitMetrics metrics{};
+		for (const auto node: dag) {
+			const auto& op = dag.at(node);
+			metrics.nops += countOps(op);
+			metrics.nmultiQubit += countMultiQubitOps(op);
+		}
+		metrics.depth = dag.depth();
+		return metrics;
+	}
+
+	std::ostream& CircuitMetrics::printJSON(std::ostream& os) const {
+		os << "{\"ops\": " << nops << ", \"multi_qubit_ops\": " << nmultiQubit << ", \"depth\": " << depth << "}";
+		return os;
+	}
+
+	PassManager& PassManager::addPass(const std::string& name, Pass pass, bool repeat) {
+		passes.push_back({name, std::move(pass), repeat});
+		return *this;
+	}
+
+	PassManager PassManager::fast() {
+		PassManager pm(2);
+		pm.addPass("cancelInverseGates", [](DAG& dag) { CircuitOptimizer::cancelInverseGates(dag, CircuitOptimizer::FAST_CANCELLATION_WINDOW); });
+		pm.addPass("singleGateFusion", [](DAG& dag) { CircuitOptimizer::singleGateFusion(dag, true); });
+		pm.addPass("removeIdentities", [](DAG& dag) { CircuitOptimizer::removeIdentities(dag); });
+		return pm;
+	}
+
+	PassManager PassManager::aggressive() {
+		PassManager pm(DEFAULT_MAX_ITERATIONS);
+		pm.addPass("eliminateSwaps", [](DAG& dag) { CircuitOptimizer::eliminateSwaps(dag); });
+		pm.addPass("cancelInverseGates", [](DAG& dag) { CircuitOptimizer::cancelInverseGates(dag); });
+		pm.addPass("mergeRotations", [](DAG& dag) { CircuitOptimizer::mergeRotations(dag); });
+		pm.addPass("singleGateFusion", [](DAG& dag) { CircuitOptimizer::singleGateFusion(dag, true); });
+		pm.addPass("removeIdentities", [](DAG& dag) { CircuitOptimizer::removeIdentities(dag); });
+		// matrix operations are opaque to all other passes
+		pm.addPass("consolidateBlocks", [](DAG& dag) { CircuitOptimizer::consolidateBlocks(dag, 2); }, false);
+		return pm;
+	}
+
+	void PassManager::execute(const Entry& entry, DAG& dag, std::size_t iteration, CircuitMetrics& metrics) {
+		PassStatistics stats{};
+		stats.name = entry.name;
+		stats.iteration = iteration;
+		stats.before = metrics;
+
+		const auto start = std::chrono::steady_clock::now();
+		entry.pass(dag);
+		const auto end = std::chrono::steady_clock::now();
+
+		stats.runtime = std::chrono::duration<double>(end - start).count();
+		metrics = CircuitMetrics::of(dag);
+		stats.after = metrics;
+		statistics.emplace_back(std::move(stats));
+	}
+
+	void PassManager::run(QuantumComputation& qc) {
+		statistics.clear();
+		iterations = 0;
+		converged = false;
+
+		DAG dag(qc);
+		initial = CircuitMetrics::of(dag);
+		auto metrics = initial;
+		const bool anyRepeated = std::any_of(passes.begin(), passes.end(), [](const Entry& e) { return e.repeat; });
+		while (anyRepeated && iterations < maxIterations) {
+			const auto before = metrics;
+			for (const auto& entry: passes) {
+				if (entry.repeat) {
+					execute(entry, dag, iterations, metrics);
+				}
+			}
+			++iterations;
+			if (metrics == before) {
+				converged = true;
+				break;
+			}
+		}
+
+		for (const auto& entry: passes) {
+			if (!entry.repeat) {
+				execute(entry, dag, iterations, metrics);
+			}
+		}
+		dag.compact();
+		result = metrics;
+	}
+
+	std::ostream& PassManager::printStatistics(std::ostream& os) const {
+		os << "{\n";
+		os << "  \"iterations\": " << iterations << ",\n";
+		os << "  \"converged\": " << (converged ? "true" : "false") << ",\n";
+		os << "  \"before\": ";
+		initial.printJSON(os) << ",\n";
+		os << "  \"after\": ";
+		result.printJSON(os) << ",\n";
+		os << "  \"passes\": [";
+		for (std::size_t i = 0; i < statistics.size(); ++i) {
+			const auto& stats = statistics[i];
+			os << (i == 0 ? "\n" : ",\n");
+			os << "    {\"name\": \"" << escapeJSON(stats.name) << "\", \"iteration\": " << stats.iteration << ", \"runtime\": " << stats.runtime << ", \"before\": ";
+			stats.before.printJSON(os) << ", \"after\": ";
+			stats.after.printJSON(os) << "}";
+		}
+		os << (statistics.empty() ? "]\n" : "\n  ]\n");
+		os << "}\n";
+		return os;
+	}
+
+	void PassManager::dumpStatistics(const std::string& filename) const {
+		std::ofstream of(filename);
+		if (!of.good()) {
+			throw QFRException("[dumpStatistics] Error opening file: " + filename);
+		}
+		printStatistics(of);
+	}
+}
@@ -0,0 +1,115 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#include "PauliExpectation.hpp"
+
+#include <cctype>
+
+namespace qc {
+	namespace {
+		std::complex<fp> weight(const dd::Edge& e) {
+			return {CN::val(e.w.r), CN::val(e.w.i)};
+		}
+	}
+
+	PauliExpectation::PauliExpectation(const dd::Edge& state, unsigned short nqubits, const permutationMap& varMap): root(state), nqubits(nqubits) {
+		qubitAt.assign(nqubits, 0);
+		std::vector<bool> used(nqubits, false);
+		for (unsigned short q = 0; q < nqubits; ++q) {
+			const auto it = varMap.find(q);
+			if (it == varMap.end() || it->second >= nqubits || used[it->second]) {
+				throw QFRException("[PauliExpectation] Variable order has to assign distinct variables in [0, " + std::to_string(nqubits) + ") to all qubits");
+			}
+			used[it->second] = true;
+			qubitAt[it->second] = q;
+		}
+		if (!dd::Package::isTerminal(root) && root.p->v != nqubits - 1) {
+			throw QFRException("[PauliExpectation] State has to consist of " + std::to_string(nqubits) + " qubits");
+		}
+	}
+
+	fp PauliExpectation::expectation(const std::string& pauli) {
+		if (pauli.size() != nqubits) {
+			throw QFRException("[PauliExpectation] Pauli string has to be of length " + std::to_string(nqubits));
+		}
+
+		// Pauli operator and suffix identifier of every variable
+		std::string paulis(nqubits, 'I');
+		std::vector<std::size_t> suffixIds(nqubits, 0);
+		std::size_t suffix = 0;
+		for (std::size_t v = 0; v < nqubits; ++v) {
+			const auto p = static_cast<char>(std::toupper(pauli[nqubits - 1 - qubitAt[v]]));
+			if (p != 'I' && p != 'X' && p != 'Y' && p != 'Z') {
+				throw QFRException("[PauliExpectation] Invalid Pauli operator " + std::string(1, pauli[nqubits - 1 - qubitAt[v]]));
+			}
+			paulis[v] = p;
+			const auto it = suffixes.emplace(std::make_pair(suffix, p), suffixes.size() + 1).first;
+			suffix = it->second;
+			suffixIds[v] = suffix;
+		}
+
+		if (dd::Package::isTerminal(root)) {
+			return std::norm(weight(root));
+		}
+		return inner(root, root, static_cast<short>(nqubits - 1), paulis, suffixIds).real();
+	}
+
+	std::vector<fp> PauliExpectation::expectation(const std::vector<std::string>& paulis) {
+		std::vector<fp> result{};
+		result.reserve(paulis.size());
+		for (const auto& pauli: paulis) {
+			result.emplace_back(expectation(pauli));
+		}
+		return result;
+	}
+
+	fp PauliExpectation::expectation(const Observable& observable) {
+		fp result = 0.;
+		for (const auto& term: observable) {
+			result += term.first * expectation(term.second);
+		}
+		return result;
+	}
+
+	std::complex<fp> PauliExpectation::inner(const dd::Edge& x, const dd::Edge& y, short v, const std::string& paulis, const std::vector<std::size_t>& suffixIds) {
+		if (CN::equalsZero(x.w) || CN::equalsZero(y.w)) {
+			return 0.;
+		}
+		const auto w = std::conj(weight(x)) * weight(y);
+		if (v < 0) {
+			return w;
+		}
+		return w * expectation(x.p, y.p, v, paulis, suffixIds);
+	}
+
+	std::complex<fp> PauliExpectation::expectation(dd::NodePtr x, dd::NodePtr y, short v, const std::string& paulis, const std::vector<std::size_t>& suffixIds) {
+		const auto key = std::make_tuple(x, y, suffixIds[static_cast<std::size_t>(v)]);
+		const auto it = computeTable.find(key);
+		if (it != computeTable.end()) {
+			return it->second;
+		}
+
+		// the successors of vector nodes reside at the edges 0 (|0>) and 2 (|1>)
+		const auto next = static_cast<short>(v - 1);
+		std::complex<fp> result{};
+		switch (paulis[static_cast<std::size_t>(v)]) {
+			case 'I':
+				result = inner(x->e[0], y->e[0], next, paulis, suffixIds) + inner(x->e[2], y->e[2], next, paulis, suffixIds);
+				break;
+			case 'Z':
+				result = inner(x->e[0], y->e[0], next, paulis, suffixIds) - inner(x->e[2], y->e[2], next, paulis, suffixIds);
+				break;
+			case 'X':
+				result = inner(x->e[0], y->e[2], next, paulis, suffixIds) + inner(x->e[2], y->e[0], next, paulis, suffixIds);
+				break;
+			default: // Y = [[0, -i], [i, 0]]
+				result = std::complex<fp>(0., -1.) * inner(x->e[0], y->e[2], next, paulis, suffixIds)
+				       + std::complex<fp>(0., 1.) * inner(x->e[2], y->e[0], next, paulis, suffixIds);
+				break;
+		}
+		computeTable[key] = result;
+		return result;
+	}
+}
@@ -4,8 +4,26 @@
  */
 
 #include "QuantumComputation.hpp"
+#include "CircuitOptimizer.hpp"
+#include "PauliExpectation.hpp"
+#include "StabilizerSimulator.hpp"
+#include "StateSampler.hpp"
 
 #include <locale>
+#include <iterator>
+#include <numeric>
+#include <functional>
+#include <tuple>
+#include <unordered_map>
+#include <cctype>
+#include <cassert>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace qc {
 	/***
@@ -354,6 +372,125 @@ namespace qc {
 		} while (p.sym != Token::Kind::eof);
 	}
 
+	std::size_t QuantumComputation::findOpenQASMStatementEnd(const std::string& content, std::size_t pos, char delimiter) {
+		while (pos < content.size()) {
+			if (content[pos] == '/' && pos+1 < content.size() && content[pos+1] == '/') {
+				pos = content.find('\n', pos);
+				if (pos == std::string::npos)
+					return std::string::npos;
+			} else if (content[pos] == '"') {
+				pos = content.find('"', pos+1);
+				if (pos == std::string::npos)
+					return std::string::npos;
+			} else if (content[pos] == delimiter) {
+				return pos;
+			}
+			++pos;
+		}
+		return std::string::npos;
+	}
+
+	void QuantumComputation::importOpenQASMParallel(std::istream& is, unsigned int nthreads) {
+		std::string content((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+
+		// split the file into the header (version, includes, register and gate declarations) and the statements of the body
+		std::size_t bodyStart = std::string::npos;
+		std::vector<std::size_t> statementEnds{};
+		bool sequential = false;
+		std::size_t pos = 0;
+		while (true) {
+			// skip whitespace and comments
+			while (pos < content.size()) {
+				if (std::isspace(static_cast<unsigned char>(content[pos]))) {
+					++pos;
+				} else if (content.compare(pos, 2, "//") == 0) {
+					pos = content.find('\n', pos);
+				} else {
+					break;
+				}
+			}
+			if (pos >= content.size())
+				break;
+
+			std::size_t wordEnd = pos;
+			while (wordEnd < content.size() && (std::isalnum(static_cast<unsigned char>(content[wordEnd])) || content[wordEnd] == '_'))
+				++wordEnd;
+			std::string word = content.substr(pos, wordEnd-pos);
+			bool declaration = (word == "OPENQASM" || word == "include" || word == "qreg" || word == "creg" || word == "gate" || word == "opaque");
+
+			if (bodyStart == std::string::npos && !declaration) {
+				bodyStart = pos;
+			}
+			// conditional statements and declarations in the body are handled by the sequential parser
+			if (bodyStart != std::string::npos && (declaration || word == "if")) {
+				sequential = true;
+				break;
+			}
+
+			std::size_t end = findOpenQASMStatementEnd(content, pos, word == "gate" ? '}' : ';');
+			if (end == std::string::npos) {
+				// let the sequential parser report the error
+				sequential = true;
+				break;
+			}
+			if (bodyStart != std::string::npos) {
+				statementEnds.emplace_back(end+1);
+			}
+			pos = end+1;
+		}
+
+		nthreads = std::min(nthreads, static_cast<unsigned int>(statementEnds.size()));
+		if (sequential || nthreads <= 1) {
+			std::istringstream iss(content);
+			importOpenQASM(iss);
+			return;
+		}
+
+		// every chunk is parsed together with the header into a separate computation
+		const std::string header = content.substr(0, bodyStart);
+		std::vector<QuantumComputation> chunks(nthreads);
+		std::vector<std::exception_ptr> errors(nthreads);
+		std::vector<std::thread> threads{};
+		threads.reserve(nthreads);
+		for (unsigned int t = 0; t < nthreads; ++t) {
+			std::size_t first = t * statementEnds.size() / nthreads;
+			std::size_t last = (t+1) * statementEnds.size() / nthreads;
+			std::size_t chunkStart = (first == 0) ? bodyStart : statementEnds[first-1];
+			std::size_t chunkEnd = statementEnds[last-1];
+			threads.emplace_back([&, t, chunkStart, chunkEnd]() {
+				try {
+					std::istringstream iss(header + content.substr(chunkStart, chunkEnd-chunkStart) + "\n");
+					chunks[t].importOpenQASM(iss);
+				} catch (...) {
+					errors[t] = std::current_exception();
+				}
+			});
+		}
+		for (auto& thread: threads) {
+			thread.join();
+		}
+		for (auto& error: errors) {
+			if (error)
+				std::rethrow_exception(error);
+		}
+
+		// all chunks share the same registers
+		nqubits = chunks.front().nqubits;
+		nclassics = chunks.front().nclassics;
+		qregs = chunks.front().qregs;
+		cregs = chunks.front().cregs;
+
+		std::size_t nops = 0;
+		for (const auto& chunk: chunks) {
+			nops += chunk.ops.size();
+		}
+		ops.reserve(nops);
+		for (auto& chunk: chunks) {
+			std::move(chunk.ops.begin(), chunk.ops.end(), std::back_inserter(ops));
+			updateMaxControls(chunk.max_controls);
+		}
+	}
+
 	void QuantumComputation::importGRCS(std::istream& is) {
 		is >> nqubits;
 		std::string line;
@@ -627,25 +764,34 @@ namespace qc {
 			import(filename, GRCS);
 		} else if (extension == "tfc") {
 			import(filename, TFC);
+		} else if (extension == "qfr") {
+			import(filename, Binary);
 		} else {
 			throw QFRException("[import] extension " + extension + " not recognized");
 		}
 	}
 
-	void QuantumComputation::import(const std::string& filename, Format format) {
+	void QuantumComputation::import(const std::string& filename, Format format, unsigned int nthreads) {
 		size_t slash = filename.find_last_of('/');
 		size_t dot = filename.find_last_of('.');
 		name = filename.substr(slash+1, dot-slash-1);
 
+		if (format == Binary) {
+			// binary files are memory-mapped instead of being read through a stream
+			reset();
+			importBinary(filename);
+			return;
+		}
+
 		auto ifs = std::ifstream(filename);
 		if (ifs.good()) {
-			import(ifs, format);
+			import(std::move(ifs), format, nthreads);
 		} else {
 			throw QFRException("[import] Error processing input stream: " + name);
 		}
 	}
 
-	void QuantumComputation::import(std::istream&& is, Format format) {
+	void QuantumComputation::import(std::istream&& is, Format format, unsigned int nthreads) {
 		// reset circuit before importing
 		reset();
 
@@ -655,7 +801,11 @@ namespace qc {
 				break;
 			case OpenQASM:
 				updateMaxControls(2);
-				importOpenQASM(is);
+				if (nthreads > 1) {
+					importOpenQASMParallel(is, nthreads);
+				} else {
+					importOpenQASM(is);
+				}
 				// try to parse initial layout from qasm file
 				is.clear();
 				is.seekg(0, std::ios::beg);
@@ -674,6 +824,9 @@ namespace qc {
 			case TFC:
 				importTFC(is);
 				break;
+			case Binary:
+				importBinary(is);
+				break;
 			default:
 				throw QFRException("[import] Format " + std::to_string(format) + " not yet supported");
 		}
@@ -1204,6 +1357,7 @@ namespace qc {
 
 
 	dd::Edge QuantumComputation::buildFunctionality(std::unique_ptr<dd::Package>& dd) {
+		assert(isCompact());
 		if (nqubits + nancillae == 0)
 			return dd->DDone;
 		
@@ -1229,17 +1383,500 @@ namespace qc {
 		return e;
 	}
 
+	dd::Edge QuantumComputation::createInitialMatrix(std::unique_ptr<dd::Package>& dd, const permutationMap& varMap) {
+		// logical qubit represented by each variable
+		std::vector<unsigned short> qubitAt(getNqubits());
+		for (const auto& entry: varMap) {
+			if (entry.first < getNqubits()) {
+				qubitAt.at(entry.second) = entry.first;
+			}
+		}
+
+		dd::Edge e = dd::Package::DDone;
+		for (short v = 0; v < getNqubits(); ++v) {
+			if (ancillary.test(qubitAt[static_cast<std::size_t>(v)])) {
+				e = dd->makeNonterminal(v, {e, dd::Package::DDzero, dd::Package::DDzero, dd::Package::DDzero});
+			} else {
+				e = dd->makeNonterminal(v, {e, dd::Package::DDzero, dd::Package::DDzero, e});
+			}
+		}
+		dd->incRef(e);
+		return e;
+	}
+
+	permutationMap QuantumComputation::completeVariableOrder(const permutationMap& varMap) const {
+		const auto n = getNqubits();
+		std::vector<bool> used(n, false);
+		for (unsigned short q = 0; q < n; ++q) {
+			const auto it = varMap.find(q);
+			if (it == varMap.end() || it->second >= n || used[it->second]) {
+				throw QFRException("[completeVariableOrder] Variable order has to assign distinct variables in [0, " + std::to_string(n) + ") to all qubits");
+			}
+			used[it->second] = true;
+		}
+
+		permutationMap result{};
+		for (unsigned short q = 0; q < MAX_QUBITS; ++q) {
+			result[q] = (q < n) ? varMap.at(q) : q;
+		}
+		return result;
+	}
+
+	permutationMap QuantumComputation::computeStaticVariableOrder() const {
+		const std::size_t n = getNqubits();
+		if (n == 0) {
+			return Operation::standardPermutation;
+		}
+
+		// interaction graph on logical qubits (uncontrolled SWAPs only change the qubit mapping)
+		std::vector<std::vector<unsigned long long>> weight(n, std::vector<unsigned long long>(n, 0));
+		std::vector<unsigned long long> controlCount(n, 0);
+		std::vector<std::size_t> firstUse(n, std::numeric_limits<std::size_t>::max());
+		permutationMap map = initialLayout;
+		std::size_t time = 0;
+		std::vector<unsigned short> qubits{};
+		std::function<void(const Operation&)> visit = [&](const Operation& op) {
+			if (op.isCompoundOperation()) {
+				for (const auto& o: dynamic_cast<const CompoundOperation&>(op)) {
+					visit(*o);
+				}
+				return;
+			}
+			if (op.isClassicControlledOperation()) {
+				visit(*dynamic_cast<const ClassicControlledOperation&>(op).getOperation());
+				return;
+			}
+			if (!op.isStandardOperation()) {
+				return;
+			}
+			if (op.getType() == SWAP && op.getControls().empty()) {
+				std::swap(map.at(op.getTargets().at(0)), map.at(op.getTargets().at(1)));
+				return;
+			}
+
+			auto logical = [&map, n](unsigned short q) {
+				const auto it = map.find(q);
+				return (it == map.end() || it->second >= n) ? std::numeric_limits<std::size_t>::max() : static_cast<std::size_t>(it->second);
+			};
+			qubits.clear();
+			for (const auto& c: op.getControls()) {
+				const auto l = logical(c.qubit);
+				if (l < n) {
+					++controlCount[l];
+					qubits.emplace_back(static_cast<unsigned short>(l));
+				}
+			}
+			for (const auto t: op.getTargets()) {
+				const auto l = logical(t);
+				if (l < n) {
+					qubits.emplace_back(static_cast<unsigned short>(l));
+				}
+			}
+			for (std::size_t i = 0; i < qubits.size(); ++i) {
+				firstUse[qubits[i]] = std::min(firstUse[qubits[i]], time);
+				for (std::size_t j = i + 1; j < qubits.size(); ++j) {
+					++weight[qubits[i]][qubits[j]];
+					++weight[qubits[j]][qubits[i]];
+				}
+			}
+			++time;
+		};
+		for (const auto& op: ops) {
+			visit(*op);
+		}
+
+		std::vector<unsigned long long> degree(n, 0);
+		for (std::size_t q = 0; q < n; ++q) {
+			degree[q] = std::accumulate(weight[q].begin(), weight[q].end(), 0ull);
+		}
+
+		// Cuthill-McKee: breadth-first search starting from the least connected qubit, visiting the strongest interactions first
+		std::vector<unsigned short> order{};
+		std::vector<bool> visited(n, false);
+		std::vector<unsigned short> neighbors{};
+		auto lessConnected = [&degree, &firstUse](unsigned short a, unsigned short b) {
+			return std::make_tuple(degree[a], firstUse[a], a) < std::make_tuple(degree[b], firstUse[b], b);
+		};
+		while (order.size() < n) {
+			unsigned short start = 0;
+			bool found = false;
+			for (unsigned short q = 0; q < n; ++q) {
+				if (!visited[q] && (!found || lessConnected(q, start))) {
+					start = q;
+					found = true;
+				}
+			}
+			visited[start] = true;
+			std::size_t head = order.size();
+			order.emplace_back(start);
+			while (head < order.size()) {
+				const auto u = order[head++];
+				neighbors.clear();
+				for (unsigned short v = 0; v < n; ++v) {
+					if (!visited[v] && weight[u][v] > 0) {
+						neighbors.emplace_back(v);
+					}
+				}
+				std::sort(neighbors.begin(), neighbors.end(), [&](unsigned short a, unsigned short b) {
+					if (weight[u][a] != weight[u][b]) {
+						return weight[u][a] > weight[u][b];
+					}
+					return lessConnected(a, b);
+				});
+				for (const auto v: neighbors) {
+					visited[v] = true;
+					order.emplace_back(v);
+				}
+			}
+		}
+
+		// higher variables are closer to the root, which is where controls should preferably reside
+		unsigned long long score = 0;
+		unsigned long long reversedScore = 0;
+		for (std::size_t k = 0; k < n; ++k) {
+			score += controlCount[order[k]] * k;
+			reversedScore += controlCount[order[k]] * (n - 1 - k);
+		}
+		if (reversedScore > score) {
+			std::reverse(order.begin(), order.end());
+		}
+
+		permutationMap varMap{};
+		for (std::size_t k = 0; k < n; ++k) {
+			varMap[order[k]] = static_cast<unsigned short>(k);
+		}
+		return completeVariableOrder(varMap);
+	}
+
+	namespace {
+		// operations which do not alter the state and, hence, do not connect any qubits
+		bool isIdentityLike(const Operation& op) {
+			const auto type = op.getType();
+			return type == Barrier || type == Snapshot || type == ShowProbabilities;
+		}
+
+		// physical qubits an operation acts on
+		void collectQubits(const Operation& op, std::vector<unsigned short>& qubits) {
+			if (isIdentityLike(op)) {
+				return;
+			}
+			if (const auto* matrixOp = dynamic_cast<const MatrixOperation*>(&op)) {
+				qubits.insert(qubits.end(), matrixOp->getQubits().begin(), matrixOp->getQubits().end());
+				return;
+			}
+			if (op.isCompoundOperation()) {
+				for (const auto& o: dynamic_cast<const CompoundOperation&>(op)) {
+					collectQubits(*o, qubits);
+				}
+				return;
+			}
+			if (op.isClassicControlledOperation()) {
+				collectQubits(*dynamic_cast<const ClassicControlledOperation&>(op).getOperation(), qubits);
+				return;
+			}
+			for (const auto& c: op.getControls()) {
+				qubits.emplace_back(c.qubit);
+			}
+			// the targets of a measurement are classical bits
+			if (op.getType() != Measure) {
+				qubits.insert(qubits.end(), op.getTargets().begin(), op.getTargets().end());
+			}
+		}
+
+		// copies a decision diagram into another package
+		dd::Edge transfer(const dd::Edge& e, std::unique_ptr<dd::Package>& to, std::unordered_map<dd::NodePtr, dd::Edge>& computed) {
+			if (CN::equalsZero(e.w)) {
+				return dd::Package::DDzero;
+			}
+
+			dd::Edge result = dd::Package::DDone;
+			if (!dd::Package::isTerminal(e)) {
+				const auto it = computed.find(e.p);
+				if (it != computed.end()) {
+					result = it->second;
+				} else {
+					std::array<dd::Edge, dd::NEDGE> edges{};
+					for (std::size_t i = 0; i < dd::NEDGE; ++i) {
+						edges[i] = transfer(e.p->e[i], to, computed);
+					}
+					result = to->makeNonterminal(e.p->v, edges);
+					computed[e.p] = result;
+				}
+			}
+
+			const auto r = CN::val(result.w.r);
+			const auto i = CN::val(result.w.i);
+			const auto wr = CN::val(e.w.r);
+			const auto wi = CN::val(e.w.i);
+			result.w = to->cn.lookup(r * wr - i * wi, r * wi + i * wr);
+			return result;
+		}
+	}
+
+	std::vector<std::vector<unsigned short>> QuantumComputation::getConnectedComponents() const {
+		const std::size_t n = getNqubits();
+		std::vector<unsigned short> parent(n);
+		std::iota(parent.begin(), parent.end(), 0);
+		auto find = [&parent](unsigned short q) {
+			while (parent[q] != q) {
+				parent[q] = parent[parent[q]];
+				q = parent[q];
+			}
+			return q;
+		};
+
+		std::vector<unsigned short> qubits{};
+		for (const auto& op: ops) {
+			qubits.clear();
+			collectQubits(*op, qubits);
+			for (std::size_t i = 1; i < qubits.size(); ++i) {
+				const auto a = find(qubits[0]);
+				const auto b = find(qubits[i]);
+				parent[std::max(a, b)] = std::min(a, b);
+			}
+		}
+
+		// components are ordered by their smallest qubit
+		std::vector<std::vector<unsigned short>> components{};
+		std::vector<std::size_t> index(n, std::numeric_limits<std::size_t>::max());
+		for (unsigned short q = 0; q < n; ++q) {
+			const auto root = find(q);
+			if (index[root] == std::numeric_limits<std::size_t>::max()) {
+				index[root] = components.size();
+				components.emplace_back();
+			}
+			components[index[root]].emplace_back(q);
+		}
+		return components;
+	}
+
+	std::pair<dd::Edge, permutationMap> QuantumComputation::buildFunctionalityByComponents(std::unique_ptr<dd::Package>& dd, unsigned int nthreads) {
+		assert(isCompact());
+		const auto n = getNqubits();
+		if (n == 0) {
+			return {dd->DDone, Operation::standardPermutation};
+		}
+
+		// logical qubits of every component (sorted)
+		const auto components = getConnectedComponents();
+		// qubits without output constraint (garbage) end up where buildFunctionality would leave them
+		const auto output = outputPositions();
+		std::vector<std::vector<unsigned short>> logical{};
+		bool decomposable = components.size() > 1;
+		for (const auto& component: components) {
+			std::vector<unsigned short> in{};
+			std::vector<unsigned short> out{};
+			for (const auto p: component) {
+				in.emplace_back(initialLayout.at(p));
+				out.emplace_back(output[p]);
+			}
+			std::sort(in.begin(), in.end());
+			std::sort(out.begin(), out.end());
+			// the output permutation must not mix the components
+			decomposable &= (in == out);
+			logical.emplace_back(std::move(in));
+		}
+		if (!decomposable) {
+			return {buildFunctionality(dd), Operation::standardPermutation};
+		}
+
+		// the order of the components determines the variable order, hence, they are ordered by their smallest logical qubit
+		std::vector<std::size_t> order(components.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&logical](std::size_t a, std::size_t b) { return logical[a].front() < logical[b].front(); });
+
+		// every component is turned into a separate computation acting on the (contiguous) qubits 0, ..., k-1
+		std::vector<unsigned short> relabeling(n, 0);
+		std::vector<std::size_t> componentOf(n, 0);
+		std::vector<QuantumComputation> parts{};
+		parts.reserve(components.size());
+		for (std::size_t c = 0; c < order.size(); ++c) {
+			const auto& component = components[order[c]];
+			const auto& logicalQubits = logical[order[c]];
+			auto rank = [&logicalQubits](unsigned short q) {
+				return static_cast<unsigned short>(std::lower_bound(logicalQubits.begin(), logicalQubits.end(), q) - logicalQubits.begin());
+			};
+
+			const auto k = static_cast<unsigned short>(component.size());
+			parts.emplace_back(k);
+			auto& part = parts.back();
+			for (unsigned short i = 0; i < k; ++i) {
+				const auto p = component[i];
+				relabeling[p] = i;
+				componentOf[p] = c;
+				part.initialLayout[i] = rank(initialLayout.at(p));
+				part.outputPermutation[i] = rank(output[p]);
+			}
+			for (const auto l: logicalQubits) {
+				part.ancillary[rank(l)] = ancillary[l];
+			}
+		}
+
+		std::vector<unsigned short> qubits{};
+		for (const auto& op: ops) {
+			if (!op->isUnitary() && !op->isClassicControlledOperation() && !isIdentityLike(*op)) {
+				throw QFRException("[buildFunctionalityByComponents] DD for non-unitary operation not available!");
+			}
+			qubits.clear();
+			collectQubits(*op, qubits);
+			if (qubits.empty()) {
+				continue;
+			}
+			auto& part = parts[componentOf[qubits.front()]];
+			auto copy = op->clone();
+			CircuitOptimizer::relabel(*copy, relabeling);
+			copy->setNqubits(part.getNqubits());
+			part.ops.emplace_back(std::move(copy));
+		}
+
+		// functionality of every component
+		std::vector<dd::Edge> functionality(parts.size());
+		nthreads = std::min(nthreads, static_cast<unsigned int>(parts.size()));
+		if (nthreads <= 1) {
+			for (std::size_t c = 0; c < parts.size(); ++c) {
+				functionality[c] = parts[c].buildFunctionality(dd);
+			}
+		} else {
+			std::vector<std::unique_ptr<dd::Package>> packages(nthreads);
+			std::vector<std::exception_ptr> errors(nthreads);
+			std::vector<std::thread> threads{};
+			threads.reserve(nthreads);
+			for (unsigned int t = 0; t < nthreads; ++t) {
+				packages[t] = std::make_unique<dd::Package>();
+				threads.emplace_back([&, t]() {
+					try {
+						for (std::size_t c = t; c < parts.size(); c += nthreads) {
+							functionality[c] = parts[c].buildFunctionality(packages[t]);
+						}
+					} catch (...) {
+						errors[t] = std::current_exception();
+					}
+				});
+			}
+			for (auto& thread: threads) {
+				thread.join();
+			}
+			for (auto& error: errors) {
+				if (error)
+					std::rethrow_exception(error);
+			}
+
+			dd->setMode(dd::Matrix);
+			std::vector<std::unordered_map<dd::NodePtr, dd::Edge>> computed(nthreads);
+			for (std::size_t c = 0; c < parts.size(); ++c) {
+				functionality[c] = transfer(functionality[c], dd, computed[c % nthreads]);
+				dd->incRef(functionality[c]);
+			}
+		}
+
+		// tensor product of all components (the first component resides at the bottom)
+		dd::Edge e = functionality.front();
+		for (std::size_t c = 1; c < functionality.size(); ++c) {
+			auto tmp = dd->kronecker(functionality[c], e);
+			dd->incRef(tmp);
+			dd->decRef(e);
+			dd->decRef(functionality[c]);
+			e = tmp;
+			dd->garbageCollect();
+		}
+
+		permutationMap varMap{};
+		unsigned short offset = 0;
+		for (const auto c: order) {
+			for (const auto l: logical[c]) {
+				varMap[l] = offset++;
+			}
+		}
+		return {e, completeVariableOrder(varMap)};
+	}
+
+	std::vector<bool> QuantumComputation::lightCone(const std::vector<unsigned short>& qubits) const {
+		// physical qubits and classical bits which (may) influence the given output qubits
+		std::vector<bool> qubitInCone(getNqubits(), false);
+		std::vector<bool> bitInCone(getNcbits(), false);
+		for (const auto q: qubits) {
+			const auto it = std::find_if(outputPermutation.begin(), outputPermutation.end(), [q](const auto& entry) { return entry.second == q; });
+			if (it == outputPermutation.end()) {
+				throw QFRException("[lightCone] Qubit " + std::to_string(q) + " is not an output of the circuit");
+			}
+			qubitInCone.at(it->first) = true;
+		}
+
+		std::vector<bool> inCone(ops.size(), false);
+		std::vector<unsigned short> opQubits{};
+		for (std::size_t i = ops.size(); i-- > 0;) {
+			const auto& op = *ops[i];
+			if (isIdentityLike(op)) {
+				continue;
+			}
+
+			// uncontrolled SWAPs only move the qubits of the cone
+			if (op.isStandardOperation() && op.getType() == SWAP && op.getControls().empty()) {
+				const auto t0 = op.getTargets().at(0);
+				const auto t1 = op.getTargets().at(1);
+				if (qubitInCone.at(t0) || qubitInCone.at(t1)) {
+					inCone[i] = true;
+					const bool tmp = qubitInCone[t0];
+					qubitInCone[t0] = qubitInCone[t1];
+					qubitInCone[t1] = tmp;
+				}
+				continue;
+			}
+
+			opQubits.clear();
+			collectQubits(op, opQubits);
+			bool relevant = std::any_of(opQubits.begin(), opQubits.end(), [&qubitInCone](unsigned short q) { return qubitInCone.at(q); });
+
+			if (op.getType() == Measure) {
+				// classical bits are overwritten by the measurement
+				for (const auto bit: op.getTargets()) {
+					if (bitInCone.at(bit)) {
+						relevant = true;
+						bitInCone[bit] = false;
+					}
+				}
+			}
+			if (!relevant) {
+				continue;
+			}
+
+			inCone[i] = true;
+			if (op.getType() == Reset) {
+				// the previous state of reset qubits does not matter
+				for (const auto q: op.getTargets()) {
+					qubitInCone.at(q) = false;
+				}
+				continue;
+			}
+			for (const auto q: opQubits) {
+				qubitInCone.at(q) = true;
+			}
+			if (op.isClassicControlledOperation()) {
+				const auto reg = dynamic_cast<const ClassicControlledOperation&>(op).getControlRegister();
+				for (unsigned short bit = reg.first; bit < reg.first + reg.second; ++bit) {
+					bitInCone.at(bit) = true;
+				}
+			}
+		}
+		return inCone;
+	}
+
 	std::pair<dd::Edge, permutationMap> QuantumComputation::buildFunctionality(std::unique_ptr<dd::Package>& dd, dd::DynamicReorderingStrategy strat) {
+		return buildFunctionality(dd, strat, Operation::standardPermutation);
+	}
+
+	std::pair<dd::Edge, permutationMap> QuantumComputation::buildFunctionality(std::unique_ptr<dd::Package>& dd, dd::DynamicReorderingStrategy strat, const permutationMap& initialVarMap) {
+		assert(isCompact());
 		if (nqubits + nancillae == 0)
 			return {dd->DDone, permutationMap{}};
 
 		std::array<short, MAX_QUBITS> line{};
 		line.fill(LINE_DEFAULT);
 		permutationMap map = initialLayout;
-		permutationMap varMap = Operation::standardPermutation;
+		permutationMap varMap = completeVariableOrder(initialVarMap);
 
 		dd->setMode(dd::Matrix);
-		dd::Edge e = createInitialMatrix(dd);
+		dd::Edge e = (varMap == Operation::standardPermutation) ? createInitialMatrix(dd) : createInitialMatrix(dd, varMap);
 		for (auto & op : ops) {
 			if (!op->isUnitary()) {
 				throw QFRException("[buildFunctionality] Functionality not unitary.");
@@ -1267,6 +1904,14 @@ namespace qc {
 	}
 
 	dd::Edge QuantumComputation::simulate(const dd::Edge& in, std::unique_ptr<dd::Package>& dd) {
+		std::vector<StateSnapshot> snapshots{};
+		auto e = simulate(in, dd, snapshots);
+		releaseSnapshots(dd, snapshots);
+		return e;
+	}
+
+	dd::Edge QuantumComputation::simulate(const dd::Edge& in, std::unique_ptr<dd::Package>& dd, std::vector<StateSnapshot>& snapshots) {
+		assert(isCompact());
 		// measurements are currently not supported here
 		std::array<short, MAX_QUBITS> line{};
 		line.fill(LINE_DEFAULT);
@@ -1275,7 +1920,12 @@ namespace qc {
 		dd::Edge e = in;
 		dd->incRef(e);
 
-		for (auto& op : ops) {
+		for (std::size_t i = 0; i < ops.size(); ++i) {
+			const auto& op = ops[i];
+			if (recordSnapshot(*op, i, e, map, snapshots, dd)) {
+				continue;
+			}
+
 			auto tmp = dd->multiply(op->getDD(dd, line, map), e);
 
 			dd->incRef(tmp);
@@ -1292,20 +1942,336 @@ namespace qc {
 		return e;
 	}
 
+	std::vector<dd::Edge> QuantumComputation::simulateBatch(const std::vector<dd::Edge>& inputs, std::unique_ptr<dd::Package>& dd) {
+		assert(isCompact());
+		std::array<short, MAX_QUBITS> line{};
+		line.fill(LINE_DEFAULT);
+		permutationMap map = initialLayout;
+		dd->setMode(dd::Vector);
+		std::vector<dd::Edge> states = inputs;
+		for (auto& e: states) {
+			dd->incRef(e);
+		}
+		if (states.empty()) {
+			return states;
+		}
+
+		for (const auto& op: ops) {
+			const auto type = op->getType();
+			if (type == Barrier || type == Snapshot || type == ShowProbabilities) {
+				continue;
+			}
+
+			// the gate DD has to survive until it has been applied to all states
+			auto gate = op->getDD(dd, line, map);
+			dd->incRef(gate);
+			for (auto& e: states) {
+				auto tmp = dd->multiply(gate, e);
+				dd->incRef(tmp);
+				dd->decRef(e);
+				e = tmp;
+			}
+			dd->decRef(gate);
+
+			dd->garbageCollect();
+		}
+
+		// correct permutation if necessary
+		for (auto& e: states) {
+			auto from = map;
+			changePermutation(e, from, outputPermutation, line, dd);
+			e = reduceAncillae(e, dd);
+		}
+		return states;
+	}
+
+	bool QuantumComputation::recordSnapshot(const Operation& op, std::size_t index, const dd::Edge& e, const permutationMap& varMap, std::vector<StateSnapshot>& snapshots, std::unique_ptr<dd::Package>& dd) const {
+		const auto type = op.getType();
+		if (type == Barrier) {
+			return true;
+		}
+		if (type != Snapshot && type != ShowProbabilities) {
+			return false;
+		}
+
+		StateSnapshot snapshot{};
+		snapshot.op = index;
+		snapshot.type = type;
+		if (type == Snapshot) {
+			snapshot.id = static_cast<int>(op.getParameter().at(0));
+			snapshot.qubits = op.getTargets();
+		} else {
+			snapshot.qubits.resize(getNqubits());
+			std::iota(snapshot.qubits.begin(), snapshot.qubits.end(), 0);
+		}
+		snapshot.state = e;
+		snapshot.varMap = varMap;
+		dd->incRef(snapshot.state);
+		snapshots.emplace_back(std::move(snapshot));
+		return true;
+	}
+
+	void QuantumComputation::releaseSnapshots(std::unique_ptr<dd::Package>& dd, std::vector<StateSnapshot>& snapshots) {
+		for (auto& snapshot: snapshots) {
+			dd->decRef(snapshot.state);
+		}
+		snapshots.clear();
+	}
+
+	namespace {
+		// probabilities of the outcomes of the marginal qubits below the given node (position[v] is the index of variable v among them or -1)
+		const std::vector<fp>& marginal(dd::NodePtr p, const std::vector<short>& position, std::size_t dim, std::unordered_map<dd::NodePtr, std::vector<fp>>& computed) {
+			const auto it = computed.find(p);
+			if (it != computed.end()) {
+				return it->second;
+			}
+
+			std::vector<fp> probabilities(dim, 0.);
+			// the successors of vector nodes reside at the edges 0 (|0>) and 2 (|1>)
+			for (std::size_t k = 0; k < 2; ++k) {
+				const auto& child = p->e[2*k];
+				const auto w = CN::mag2(child.w);
+				if (w == 0.) {
+					continue;
+				}
+				const auto pos = position.at(static_cast<std::size_t>(p->v));
+				const std::size_t bit = (k == 1 && pos >= 0) ? (1ull << static_cast<std::size_t>(pos)) : 0;
+				if (dd::Package::isTerminal(child)) {
+					probabilities[bit] += w;
+					continue;
+				}
+				const auto& sub = marginal(child.p, position, dim, computed);
+				for (std::size_t i = 0; i < dim; ++i) {
+					probabilities[i | bit] += w * sub[i];
+				}
+			}
+			return computed.emplace(p, std::move(probabilities)).first->second;
+		}
+	}
+
+	std::vector<fp> QuantumComputation::getMarginalProbabilities(const dd::Edge& state, const std::vector<unsigned short>& qubits, const permutationMap& varMap) {
+		if (qubits.size() >= std::numeric_limits<std::size_t>::digits) {
+			throw QFRException("[getMarginalProbabilities] Too many qubits");
+		}
+		const std::size_t dim = 1ull << qubits.size();
+		const auto w = CN::mag2(state.w);
+		if (w == 0. || dd::Package::isTerminal(state)) {
+			std::vector<fp> probabilities(dim, 0.);
+			probabilities[0] = w;
+			return probabilities;
+		}
+
+		std::vector<short> position(static_cast<std::size_t>(state.p->v) + 1, -1);
+		for (std::size_t k = 0; k < qubits.size(); ++k) {
+			const auto it = varMap.find(qubits[k]);
+			if (it == varMap.end() || it->second >= position.size() || position[it->second] >= 0) {
+				throw QFRException("[getMarginalProbabilities] Invalid or duplicate qubit " + std::to_string(qubits[k]));
+			}
+			position[it->second] = static_cast<short>(k);
+		}
+
+		std::unordered_map<dd::NodePtr, std::vector<fp>> computed{};
+		auto probabilities = marginal(state.p, position, dim, computed);
+		for (auto& p: probabilities) {
+			p *= w;
+		}
+		return probabilities;
+	}
+
+	bool QuantumComputation::isClifford() const {
+		return StabilizerSimulator::isClifford(*this);
+	}
+
+	namespace {
+		bool isMeasurementOrReset(const Operation& op) {
+			if (op.isCompoundOperation()) {
+				const auto& compound = dynamic_cast<const CompoundOperation&>(op);
+				return std::any_of(compound.begin(), compound.end(), [](const std::unique_ptr<Operation>& o) { return isMeasurementOrReset(*o); });
+			}
+			return op.getType() == Measure || op.getType() == Reset;
+		}
+
+		void trackSwaps(const Operation& op, permutationMap& map) {
+			if (op.isCompoundOperation()) {
+				for (const auto& o: dynamic_cast<const CompoundOperation&>(op)) {
+					trackSwaps(*o, map);
+				}
+			} else if (op.isStandardOperation() && op.getType() == SWAP && op.getControls().empty()) {
+				std::swap(map.at(op.getTargets().at(0)), map.at(op.getTargets().at(1)));
+			}
+		}
+	}
+
+	std::vector<unsigned short> QuantumComputation::outputPositions() const {
+		// qubit mapping at the end of the circuit (a stabilizer simulation moves the qubits instead of tracking the mapping)
+		permutationMap map = initialLayout;
+		for (const auto& op: ops) {
+			trackSwaps(*op, map);
+		}
+
+		// same exchanges as changePermutation, i.e., qubits without output constraint end up where these exchanges leave them
+		for (const auto& kv: outputPermutation) {
+			const auto current = map.at(kv.first);
+			if (current == kv.second) {
+				continue;
+			}
+			const auto j = std::find_if(map.begin(), map.end(), [&kv](const std::pair<const unsigned short, unsigned short>& entry) { return entry.second == kv.second; });
+			if (j == map.end()) {
+				throw QFRException("[outputPositions] Output " + std::to_string(kv.second) + " not found in qubit mapping");
+			}
+			j->second = current;
+			map.at(kv.first) = kv.second;
+		}
+
+		const auto n = getNqubits();
+		std::vector<unsigned short> position(n);
+		for (unsigned short q = 0; q < n; ++q) {
+			position[q] = map.at(q);
+			if (position[q] >= n) {
+				throw QFRException("[outputPositions] Qubit " + std::to_string(q) + " is mapped to invalid output " + std::to_string(position[q]));
+			}
+		}
+		return position;
+	}
+
+	std::map<std::string, std::size_t> QuantumComputation::sample(std::size_t shots, std::unique_ptr<dd::Package>& dd, std::uint64_t seed) {
+		assert(isCompact());
+		const auto n = getNqubits();
+		if (!isClifford()) {
+			auto e = simulate(dd->makeZeroState(n), dd);
+			const StateSampler sampler(e, n);
+			auto counts = sampler.sample(shots, 1, seed);
+			dd->decRef(e);
+			return counts;
+		}
+
+		const auto position = outputPositions();
+		auto permute = [&position, n](const std::string& bits) {
+			std::string result(n, '0');
+			for (unsigned short q = 0; q < n; ++q) {
+				result[n - 1 - position[q]] = bits[n - 1 - q];
+			}
+			return result;
+		};
+
+		// everything before the first measurement or reset is the same for all shots
+		const auto firstMeasurement = static_cast<std::size_t>(std::find_if(ops.begin(), ops.end(), [](const std::unique_ptr<Operation>& op) { return isMeasurementOrReset(*op); }) - ops.begin());
+		std::vector<bool> cbits(getNcbits(), false);
+		StabilizerSimulator prefix(n, seed);
+		for (std::size_t i = 0; i < firstMeasurement; ++i) {
+			prefix.apply(*ops[i], cbits);
+		}
+
+		std::map<std::string, std::size_t> counts{};
+		if (firstMeasurement == ops.size()) {
+			for (const auto& entry: prefix.sample(shots)) {
+				counts[permute(entry.first)] += entry.second;
+			}
+			return counts;
+		}
+
+		StabilizerSimulator simulator(n, seed);
+		for (std::size_t shot = 0; shot < shots; ++shot) {
+			simulator.setState(prefix);
+			for (std::size_t i = firstMeasurement; i < ops.size(); ++i) {
+				simulator.apply(*ops[i], cbits);
+			}
+			++counts[permute(simulator.measureAll())];
+		}
+		return counts;
+	}
+
+	fp QuantumComputation::expectationValue(const std::string& pauli, std::unique_ptr<dd::Package>& dd) {
+		const auto n = getNqubits();
+		if (pauli.size() != n) {
+			throw QFRException("[expectationValue] Pauli string has to be of length " + std::to_string(n));
+		}
+		if (std::any_of(ops.begin(), ops.end(), [](const std::unique_ptr<Operation>& op) { return isMeasurementOrReset(*op); })) {
+			throw QFRException("[expectationValue] Circuits containing measurements or resets are not supported");
+		}
+		if (!isClifford()) {
+			auto e = simulate(dd->makeZeroState(n), dd);
+			PauliExpectation expectation(e, n);
+			const auto result = expectation.expectation(pauli);
+			dd->decRef(e);
+			return result;
+		}
+
+		const auto position = outputPositions();
+		std::string permuted(n, 'I');
+		for (unsigned short q = 0; q < n; ++q) {
+			permuted[n - 1 - q] = pauli[n - 1 - position[q]];
+		}
+		StabilizerSimulator simulator(n);
+		simulator.run(*this);
+		return simulator.expectation(permuted);
+	}
+
+	dd::Edge QuantumComputation::simulateLightCone(const dd::Edge& in, std::unique_ptr<dd::Package>& dd, const std::vector<unsigned short>& qubits) {
+		assert(isCompact());
+		const auto inCone = lightCone(qubits);
+
+		std::array<short, MAX_QUBITS> line{};
+		line.fill(LINE_DEFAULT);
+		permutationMap map = initialLayout;
+		dd->setMode(dd::Vector);
+		dd::Edge e = in;
+		dd->incRef(e);
+
+		for (std::size_t i = 0; i < ops.size(); ++i) {
+			if (!inCone[i]) {
+				continue;
+			}
+			auto tmp = dd->multiply(ops[i]->getDD(dd, line, map), e);
+
+			dd->incRef(tmp);
+			dd->decRef(e);
+			e = tmp;
+
+			dd->garbageCollect();
+		}
+
+		// correct permutation if necessary
+		changePermutation(e, map, outputPermutation, line, dd);
+		e = reduceAncillae(e, dd);
+
+		return e;
+	}
 
 	std::pair<dd::Edge, permutationMap> QuantumComputation::simulate(const dd::Edge& in, std::unique_ptr<dd::Package>& dd, dd::DynamicReorderingStrategy strat) {
+		return simulate(in, dd, strat, Operation::standardPermutation);
+	}
+
+	std::pair<dd::Edge, permutationMap> QuantumComputation::simulate(const dd::Edge& in, std::unique_ptr<dd::Package>& dd, dd::DynamicReorderingStrategy strat, const permutationMap& initialVarMap) {
+		std::vector<StateSnapshot> snapshots{};
+		auto result = simulate(in, dd, strat, initialVarMap, snapshots);
+		releaseSnapshots(dd, snapshots);
+		return result;
+	}
+
+	std::pair<dd::Edge, permutationMap> QuantumComputation::simulate(const dd::Edge& in, std::unique_ptr<dd::Package>& dd, dd::DynamicReorderingStrategy strat, const permutationMap& initialVarMap, std::vector<StateSnapshot>& snapshots) {
+		assert(isCompact());
 		// measurements are currently not supported here
 		std::array<short, MAX_QUBITS> line{};
 		line.fill(LINE_DEFAULT);
 		permutationMap map = initialLayout;
-		permutationMap varMap = Operation::standardPermutation;
+		permutationMap varMap = completeVariableOrder(initialVarMap);
 
 		dd->setMode(dd::Vector);
 		dd::Edge e = in;
 		dd->incRef(e);
 
-		for (auto& op : ops) {
+		for (std::size_t i = 0; i < ops.size(); ++i) {
+			const auto& op = ops[i];
 			if (!op->isUnitary()) {
+				// qubit -> DD variable at this point of the simulation
+				permutationMap current{};
+				for (const auto& entry: map) {
+					current[entry.first] = varMap.at(entry.second);
+				}
+				if (recordSnapshot(*op, i, e, current, snapshots, dd)) {
+					continue;
+				}
 				throw QFRException("[simulate] Functionality not unitary.");
 			}
 
@@ -1329,7 +2295,6 @@ namespace qc {
 	void QuantumComputation::create_reg_array(const registerMap& regs, regnames_t& regnames, unsigned short defaultnumber, const char* defaultname) {
 		regnames.clear();
 
-		std::stringstream ss;
 		if(!regs.empty()) {
 			// sort regs by start index
 			std::map<unsigned short, std::pair<std::string, reg>> sortedRegs{};
@@ -1339,21 +2304,20 @@ namespace qc {
 
 			for(const auto& reg: sortedRegs) {
 				for(unsigned short i = 0; i < reg.second.second.second; i++) {
-					ss << reg.second.first << "[" << i << "]";
-					regnames.push_back(std::make_pair(reg.second.first, ss.str()));
-					ss.str(std::string());
+					regnames.emplace_back(reg.second.first, reg.second.first + "[" + std::to_string(i) + "]");
 				}
 			}
 		} else {
+			const std::string name(defaultname);
+			regnames.reserve(defaultnumber);
 			for(unsigned short i = 0; i < defaultnumber; i++) {
-				ss << defaultname << "[" << i << "]";
-				regnames.push_back(std::make_pair(defaultname, ss.str()));
-				ss.str(std::string());
+				regnames.emplace_back(name, name + "[" + std::to_string(i) + "]");
 			}
 		}
 	}
 
 	std::ostream& QuantumComputation::print(std::ostream& os) const {
+		assert(isCompact());
 		os << std::setw((int)std::log10(ops.size())+1) << "i" << ": \t\t\t";
 		for (const auto& Q: initialLayout) {
 			if (ancillary.test(Q.second))
@@ -1456,6 +2420,8 @@ namespace qc {
 			dump(filename, OpenQASM);
 		} else if(extension == "py") {
 			dump(filename, Qiskit);
+		} else if (extension == "qfr") {
+			dump(filename, Binary);
 		} else {
 			throw QFRException("[dump] Extension " + extension + " not recognized/supported for dumping.");
 		}
@@ -1494,7 +2460,7 @@ namespace qc {
 		}
 	}
 
-	void QuantumComputation::dumpOpenQASM(std::ostream& of) {
+	void QuantumComputation::dumpOpenQASM(std::ostream& of, unsigned int nthreads) {
 		// Add missing physical qubits
 		if(!qregs.empty()) {
 			for (unsigned short physical_qubit=0; physical_qubit < initialLayout.rbegin()->first; ++physical_qubit) {
@@ -1513,7 +2479,7 @@ namespace qc {
 		for (const auto& q: inverseInitialLayout) {
 			of << " " << q.second;
 		}
-		of << std::endl;
+		of << '\n';
 
 		permutationMap inverseOutputPermutation {};
 		for (const auto& q: outputPermutation) {
@@ -1523,24 +2489,24 @@ namespace qc {
 		for (const auto& q: inverseOutputPermutation) {
 			of << " " << q.second;
 		}
-		of << std::endl;
+		of << '\n';
 
-		of << "OPENQASM 2.0;"                << std::endl;
-		of << "include \"qelib1.inc\";"      << std::endl;
+		of << "OPENQASM 2.0;"                << '\n';
+		of << "include \"qelib1.inc\";"      << '\n';
 		if (!qregs.empty()){
 			printSortedRegisters(qregs, "qreg", of);
 		} else if (nqubits > 0) {
-			of << "qreg " << DEFAULT_QREG << "[" << nqubits   << "];" << std::endl;
+			of << "qreg " << DEFAULT_QREG << "[" << nqubits   << "];" << '\n';
 		}
 		if(!cregs.empty()) {
 			printSortedRegisters(cregs, "creg", of);
 		} else if (nclassics > 0) {
-			of << "creg " << DEFAULT_CREG << "[" << nclassics << "];" << std::endl;
+			of << "creg " << DEFAULT_CREG << "[" << nclassics << "];" << '\n';
 		}
 		if(!ancregs.empty()) {
 			printSortedRegisters(ancregs, "qreg", of);
 		} else if (nancillae > 0) {
-			of << "qreg " << DEFAULT_ANCREG << "[" << nancillae << "];" << std::endl;
+			of << "qreg " << DEFAULT_ANCREG << "[" << nancillae << "];" << '\n';
 		}
 
 		regnames_t qregnames{};
@@ -1553,8 +2519,407 @@ namespace qc {
 		for (auto& ancregname: ancregnames)
 			qregnames.push_back(ancregname);
 
+		// the register name tables are built once and shared by all threads
+		dumpOperations(of, nthreads, [&](const Operation& op, std::ostream& os) {
+			op.dumpOpenQASM(os, qregnames, cregnames);
+		});
+	}
+
+	void QuantumComputation::dumpOperations(std::ostream& of, unsigned int nthreads, const std::function<void(const Operation&, std::ostream&)>& dumpOperation) const {
+		assert(isCompact());
+		if (nthreads <= 1 || ops.size() < 2*nthreads*DUMP_MIN_CHUNK) {
+			for (const auto& op: ops) {
+				dumpOperation(*op, of);
+			}
+			return;
+		}
+
+		nthreads = static_cast<unsigned int>(std::min<std::size_t>(nthreads, ops.size() / DUMP_MIN_CHUNK));
+		const std::size_t chunkSize = (ops.size() + nthreads - 1) / nthreads;
+		std::vector<std::string> chunks(nthreads);
+		std::vector<std::exception_ptr> errors(nthreads);
+		std::vector<std::thread> threads{};
+		threads.reserve(nthreads);
+		for (unsigned int t = 0; t < nthreads; ++t) {
+			threads.emplace_back([&, t]() {
+				try {
+					std::ostringstream ss{};
+					const auto first = std::min(ops.size(), t*chunkSize);
+					const auto last = std::min(ops.size(), first + chunkSize);
+					for (auto i = first; i < last; ++i) {
+						dumpOperation(*ops[i], ss);
+					}
+					chunks[t] = ss.str();
+				} catch (...) {
+					errors[t] = std::current_exception();
+				}
+			});
+		}
+		for (auto& thread: threads) {
+			thread.join();
+		}
+		for (const auto& error: errors) {
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		}
+		// ordered concatenation of the formatted op ranges
+		for (const auto& chunk: chunks) {
+			of.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+		}
+	}
+
+	std::size_t QuantumComputation::compact() {
+		const auto nops = ops.size();
+		ops.erase(std::remove(ops.begin(), ops.end(), nullptr), ops.end());
+		return nops - ops.size();
+	}
+
+	void QuantumComputation::insert(std::vector<std::pair<std::size_t, std::unique_ptr<Operation>>>&& insertions) {
+		if (insertions.empty()) {
+			return;
+		}
+		std::stable_sort(insertions.begin(), insertions.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+		if (insertions.back().first > ops.size()) {
+			throw QFRException("[insert] Insertion position out of range");
+		}
+
+		std::vector<std::unique_ptr<Operation>> merged{};
+		merged.reserve(ops.size() + insertions.size());
+		auto insertion = insertions.begin();
+		for (std::size_t i = 0; i < ops.size(); ++i) {
+			while (insertion != insertions.end() && insertion->first == i) {
+				merged.emplace_back(std::move(insertion->second));
+				++insertion;
+			}
+			merged.emplace_back(std::move(ops[i]));
+		}
+		for (; insertion != insertions.end(); ++insertion) {
+			merged.emplace_back(std::move(insertion->second));
+		}
+		ops = std::move(merged);
+	}
+
+	void QuantumComputation::dumpBinary(std::ostream& of) {
+		assert(isCompact());
+		auto write = [&of](auto value) {
+			of.write(reinterpret_cast<const char*>(&value), sizeof(value));
+		};
+		auto writeString = [&](const std::string& s) {
+			write(static_cast<std::uint16_t>(s.size()));
+			of.write(s.data(), static_cast<std::streamsize>(s.size()));
+		};
+		auto writeRegisters = [&](const registerMap& regs) {
+			write(static_cast<std::uint16_t>(regs.size()));
+			for (const auto& reg: regs) {
+				writeString(reg.first);
+				write(static_cast<std::uint16_t>(reg.second.first));
+				write(static_cast<std::uint16_t>(reg.second.second));
+			}
+		};
+		auto writePermutation = [&](const permutationMap& map) {
+			write(static_cast<std::uint16_t>(map.size()));
+			for (const auto& q: map) {
+				write(static_cast<std::uint16_t>(q.first));
+				write(static_cast<std::uint16_t>(q.second));
+			}
+		};
+		auto writeBitset = [&](const std::bitset<MAX_QUBITS>& bits) {
+			auto nbytes = static_cast<std::uint16_t>((getNqubits() + 7) / 8);
+			write(nbytes);
+			for (std::uint16_t i = 0; i < nbytes; ++i) {
+				std::uint8_t byte = 0;
+				for (unsigned short j = 0; j < 8 && i*8u+j < MAX_QUBITS; ++j) {
+					if (bits.test(i*8u+j))
+						byte |= static_cast<std::uint8_t>(1u << j);
+				}
+				write(byte);
+			}
+		};
+
+		of.write(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+		write(BINARY_VERSION);
+		write(static_cast<std::uint16_t>(nqubits));
+		write(static_cast<std::uint16_t>(nclassics));
+		write(static_cast<std::uint16_t>(nancillae));
+		write(static_cast<std::uint16_t>(max_controls));
+		writeString(name);
+		writeRegisters(qregs);
+		writeRegisters(cregs);
+		writeRegisters(ancregs);
+		writePermutation(initialLayout);
+		writePermutation(outputPermutation);
+		writeBitset(ancillary);
+		writeBitset(garbage);
+
+		write(static_cast<std::uint64_t>(ops.size()));
 		for (const auto& op: ops) {
-			op->dumpOpenQASM(of, qregnames, cregnames);
+			dumpBinaryOperation(*op, of);
+		}
+	}
+
+	void QuantumComputation::dumpBinaryOperation(const Operation& op, std::ostream& of) {
+		auto write = [&of](auto value) {
+			of.write(reinterpret_cast<const char*>(&value), sizeof(value));
+		};
+
+		write(static_cast<std::uint8_t>(op.getType()));
+		if (op.isCompoundOperation()) {
+			if (const auto* matrixOp = dynamic_cast<const MatrixOperation*>(&op)) {
+				matrixOp->checkExportable();
+			}
+			const auto& compound = dynamic_cast<const CompoundOperation&>(op);
+			write(static_cast<std::uint32_t>(compound.size()));
+			for (const auto& subop: compound) {
+				dumpBinaryOperation(*subop, of);
+			}
+			return;
+		}
+		if (op.isClassicControlledOperation()) {
+			const auto& classicControlled = dynamic_cast<const ClassicControlledOperation&>(op);
+			write(static_cast<std::uint16_t>(classicControlled.getControlRegister().first));
+			write(static_cast<std::uint16_t>(classicControlled.getControlRegister().second));
+			write(static_cast<std::uint32_t>(classicControlled.getExpectedValue()));
+			dumpBinaryOperation(*classicControlled.getOperation(), of);
+			return;
+		}
+
+		// qubit indices fit into 15 bits, the highest bit of a control marks a negative control
+		write(static_cast<std::uint8_t>(op.getNtargets()));
+		write(static_cast<std::uint8_t>(op.getNcontrols()));
+		for (const auto& target: op.getTargets()) {
+			write(static_cast<std::uint16_t>(target));
+		}
+		for (const auto& control: op.getControls()) {
+			write(static_cast<std::uint16_t>(control.qubit | (control.type == Control::neg ? 0x8000u : 0u)));
+		}
+		// only write parameters up to the last non-zero one
+		std::uint8_t nparams = MAX_PARAMETERS;
+		while (nparams > 0 && op.getParameter()[nparams-1] == 0) {
+			--nparams;
+		}
+		write(nparams);
+		for (std::uint8_t i = 0; i < nparams; ++i) {
+			write(static_cast<double>(op.getParameter()[i]));
+		}
+	}
+
+	void QuantumComputation::importBinary(std::istream& is) {
+		std::string content((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+		importBinary(content.data(), content.size());
+	}
+
+	void QuantumComputation::importBinary(const std::string& filename) {
+#if defined(__unix__) || defined(__APPLE__)
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd < 0) {
+			throw QFRException("[import] Error processing input stream: " + name);
+		}
+		struct stat sb{};
+		if (fstat(fd, &sb) < 0) {
+			close(fd);
+			throw QFRException("[import] Error processing input stream: " + name);
+		}
+		auto size = static_cast<std::size_t>(sb.st_size);
+		if (size == 0) {
+			close(fd);
+			importBinary(nullptr, 0);
+			return;
+		}
+		void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (data == MAP_FAILED) {
+			throw QFRException("[import] Error mapping file: " + filename);
+		}
+		try {
+			importBinary(static_cast<const char*>(data), size);
+		} catch (...) {
+			munmap(data, size);
+			throw;
+		}
+		munmap(data, size);
+#else
+		auto ifs = std::ifstream(filename, std::ios::in | std::ios::binary);
+		if (!ifs.good()) {
+			throw QFRException("[import] Error processing input stream: " + name);
+		}
+		importBinary(ifs);
+#endif
+	}
+
+	void QuantumComputation::importBinary(const char* data, std::size_t size) {
+		std::size_t pos = 0;
+		auto read = [&](auto& value) {
+			if (pos + sizeof(value) > size) {
+				throw QFRException("[import] Unexpected end of binary circuit file");
+			}
+			std::memcpy(&value, data + pos, sizeof(value));
+			pos += sizeof(value);
+		};
+		auto readString = [&]() {
+			std::uint16_t length = 0;
+			read(length);
+			if (pos + length > size) {
+				throw QFRException("[import] Unexpected end of binary circuit file");
+			}
+			std::string s(data + pos, length);
+			pos += length;
+			return s;
+		};
+		auto readRegisters = [&](registerMap& regs) {
+			std::uint16_t count = 0;
+			read(count);
+			for (std::uint16_t i = 0; i < count; ++i) {
+				auto regname = readString();
+				std::uint16_t start = 0, length = 0;
+				read(start);
+				read(length);
+				regs.insert({regname, {start, length}});
+			}
+		};
+		auto readPermutation = [&](permutationMap& map) {
+			std::uint16_t count = 0;
+			read(count);
+			for (std::uint16_t i = 0; i < count; ++i) {
+				std::uint16_t from = 0, to = 0;
+				read(from);
+				read(to);
+				map.insert({from, to});
+			}
+		};
+		auto readBitset = [&](std::bitset<MAX_QUBITS>& bits) {
+			std::uint16_t nbytes = 0;
+			read(nbytes);
+			for (std::uint16_t i = 0; i < nbytes; ++i) {
+				std::uint8_t byte = 0;
+				read(byte);
+				for (unsigned short j = 0; j < 8 && i*8u+j < MAX_QUBITS; ++j) {
+					bits.set(i*8u+j, (byte >> j) & 1u);
+				}
+			}
+		};
+
+		if (size < sizeof(BINARY_MAGIC) || std::memcmp(data, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0) {
+			throw QFRException("[import] File is not a binary circuit file");
+		}
+		pos += sizeof(BINARY_MAGIC);
+		std::uint16_t version = 0;
+		read(version);
+		if (version > BINARY_VERSION) {
+			throw QFRException("[import] Binary circuit file version " + std::to_string(version) + " not supported");
+		}
+
+		std::uint16_t value = 0;
+		read(value);
+		nqubits = value;
+		read(value);
+		nclassics = value;
+		read(value);
+		nancillae = value;
+		read(value);
+		max_controls = value;
+		auto circuitName = readString();
+		if (!circuitName.empty()) {
+			name = circuitName;
+		}
+		readRegisters(qregs);
+		readRegisters(cregs);
+		readRegisters(ancregs);
+		readPermutation(initialLayout);
+		readPermutation(outputPermutation);
+		readBitset(ancillary);
+		readBitset(garbage);
+
+		std::uint64_t nops = 0;
+		read(nops);
+		ops.reserve(nops);
+		for (std::uint64_t i = 0; i < nops; ++i) {
+			ops.emplace_back(importBinaryOperation(data, size, pos));
+		}
+	}
+
+	std::unique_ptr<Operation> QuantumComputation::importBinaryOperation(const char* data, std::size_t size, std::size_t& pos) {
+		auto read = [&](auto& value) {
+			if (pos + sizeof(value) > size) {
+				throw QFRException("[import] Unexpected end of binary circuit file");
+			}
+			std::memcpy(&value, data + pos, sizeof(value));
+			pos += sizeof(value);
+		};
+
+		const auto nq = getNqubits();
+		std::uint8_t opcode = 0;
+		read(opcode);
+		if (opcode == None || opcode > ClassicControlled) {
+			throw QFRException("[import] Invalid operation type " + std::to_string(opcode) + " in binary circuit file");
+		}
+		auto type = static_cast<OpType>(opcode);
+
+		if (type == Compound) {
+			std::uint32_t count = 0;
+			read(count);
+			auto compound = std::make_unique<CompoundOperation>(nq);
+			for (std::uint32_t i = 0; i < count; ++i) {
+				auto op = importBinaryOperation(data, size, pos);
+				compound->emplace_back(op);
+			}
+			return compound;
+		}
+		if (type == ClassicControlled) {
+			std::pair<unsigned short, unsigned short> controlRegister{};
+			std::uint16_t value = 0;
+			read(value);
+			controlRegister.first = value;
+			read(value);
+			controlRegister.second = value;
+			std::uint32_t expectedValue = 0;
+			read(expectedValue);
+			auto op = importBinaryOperation(data, size, pos);
+			return std::make_unique<ClassicControlledOperation>(op, controlRegister, expectedValue);
+		}
+
+		std::uint8_t ntargets = 0, ncontrols = 0;
+		read(ntargets);
+		read(ncontrols);
+		std::vector<unsigned short> targets(ntargets);
+		for (auto& target: targets) {
+			std::uint16_t q = 0;
+			read(q);
+			target = q;
+		}
+		std::vector<Control> controls{};
+		controls.reserve(ncontrols);
+		for (std::uint8_t i = 0; i < ncontrols; ++i) {
+			std::uint16_t q = 0;
+			read(q);
+			controls.emplace_back(static_cast<unsigned short>(q & 0x7FFFu), (q & 0x8000u) ? Control::neg : Control::pos);
+		}
+		std::uint8_t nparams = 0;
+		read(nparams);
+		if (nparams > MAX_PARAMETERS) {
+			throw QFRException("[import] Invalid number of parameters in binary circuit file");
+		}
+		std::array<double, MAX_PARAMETERS> params{};
+		for (std::uint8_t i = 0; i < nparams; ++i) {
+			read(params[i]);
+		}
+
+		switch (type) {
+			case Measure: {
+				std::vector<unsigned short> qubits{};
+				for (const auto& control: controls)
+					qubits.emplace_back(control.qubit);
+				return std::make_unique<NonUnitaryOperation>(nq, qubits, targets);
+			}
+			case Snapshot:
+				return std::make_unique<NonUnitaryOperation>(nq, targets, static_cast<int>(params[0]));
+			case ShowProbabilities:
+				return std::make_unique<NonUnitaryOperation>(nq);
+			case Reset:
+			case Barrier:
+				return std::make_unique<NonUnitaryOperation>(nq, targets, type);
+			default:
+				return std::make_unique<StandardOperation>(nq, controls, targets, type, params[0], params[1], params[2]);
 		}
 	}
 
@@ -1566,16 +2931,30 @@ namespace qc {
 		}
 
 		for (auto const& reg : sortedRegs) {
-			of << identifier << " " << reg.second.first << "[" << reg.second.second.second << "];" << std::endl;
+			of << identifier << " " << reg.second.first << "[" << reg.second.second.second << "];" << '\n';
 		}
 	}
 
-	void QuantumComputation::dump(const std::string& filename, Format format) {
-		auto of = std::ofstream(filename);
+	void QuantumComputation::dump(const std::string& filename, Format format, unsigned int nthreads) {
+		if (nthreads > 1 && format != OpenQASM && format != Qiskit) {
+			throw QFRException("[dump] Parallel dumping is only supported for OpenQASM and Qiskit output");
+		}
+		// a large file buffer avoids issuing a write for every few lines of output
+		std::vector<char> buffer(DUMP_BUFFER_SIZE);
+		std::ofstream of{};
+		of.rdbuf()->pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		of.open(filename, format == Binary ? std::ios::out | std::ios::binary : std::ios::out);
 		if (!of.good()) {
 			throw QFRException("[dump] Error opening file: " + filename);
 		}
-		dump(of, format);
+		if (format == OpenQASM) {
+			dumpOpenQASM(of, nthreads);
+		} else if (format == Qiskit) {
+			dumpQiskit(of, nthreads);
+		} else {
+			dump(of, format);
+		}
+		of.close();
 	}
 
 	void QuantumComputation::dump(std::ostream&& of, Format format) {
@@ -1593,118 +2972,125 @@ namespace qc {
 			case TFC:
 				std::cerr << "Dumping in TFC format currently not supported\n";
 				break;
+			case Binary:
+				dumpBinary(of);
+				break;
 			case Qiskit:
-				// TODO: improve/modernize Qiskit dump
-				unsigned short totalQubits = nqubits + nancillae + (max_controls >= 2? max_controls-2: 0);
-				if (totalQubits > 53) {
-					std::cerr << "No more than 53 total qubits are currently supported" << std::endl;
-					break;
-				}
-
-				// For the moment all registers are fused together into for simplicity
-				// This may be adapted in the future
-				of << "from qiskit import *" << std::endl;
-				of << "from qiskit.test.mock import ";
-				unsigned short narchitecture = 0;
-				if (totalQubits <= 5) {
-					of << "FakeBurlington";
-					narchitecture = 5;
-				} else if (totalQubits <= 20) {
-					of << "FakeBoeblingen";
-					narchitecture = 20;
-				} else if (totalQubits <= 53) {
-					of << "FakeRochester";
-					narchitecture = 53;
-				}
-				of << std::endl;
-				of << "from qiskit.converters import circuit_to_dag, dag_to_circuit" << std::endl;
-				of << "from qiskit.transpiler.passes import *" << std::endl;
-				of << "from math import pi" << std::endl << std::endl;
-
-				of << DEFAULT_QREG << " = QuantumRegister(" << nqubits << ", '" << DEFAULT_QREG << "')" << std::endl;
-				if (nclassics > 0) {
-					of << DEFAULT_CREG << " = ClassicalRegister(" << nclassics << ", '" << DEFAULT_CREG << "')" << std::endl;
-				}
-				if (nancillae > 0) {
-					of << DEFAULT_ANCREG << " = QuantumRegister(" << nancillae << ", '" << DEFAULT_ANCREG << "')" << std::endl;
-				}
-				if (max_controls > 2) {
-					of << DEFAULT_MCTREG << " = QuantumRegister(" << max_controls - 2 << ", '"<< DEFAULT_MCTREG << "')" << std::endl;
-				}
-				of << "qc = QuantumCircuit(";
-				of << DEFAULT_QREG;
-				if (nclassics > 0) {
-					of << ", " << DEFAULT_CREG;
-				}
-				if (nancillae > 0) {
-					of << ", " << DEFAULT_ANCREG;
-				}
-				if(max_controls > 2) {
-					of << ", " << DEFAULT_MCTREG;
-				}
-				of << ")" << std::endl << std::endl;
-
-				regnames_t qregnames{};
-				regnames_t cregnames{};
-				regnames_t ancregnames{};
-				create_reg_array({}, qregnames, nqubits, DEFAULT_QREG);
-				create_reg_array({}, cregnames, nclassics, DEFAULT_CREG);
-				create_reg_array({}, ancregnames, nancillae, DEFAULT_ANCREG);
-
-				for (auto& ancregname: ancregnames)
-					qregnames.push_back(ancregname);
-
-				for (const auto& op: ops) {
-					op->dumpQiskit(of, qregnames, cregnames, DEFAULT_MCTREG);
-				}
-				// add measurement for determining output mapping
-				of << "qc.measure_all()" << std::endl;
-
-				of << "qc_transpiled = transpile(qc, backend=";
-				if (totalQubits <= 5) {
-					of << "FakeBurlington";
-				} else if (totalQubits <= 20) {
-					of << "FakeBoeblingen";
-				} else if (totalQubits <= 53) {
-					of << "FakeRochester";
-				}
-				of << "(), optimization_level=1)" << std::endl << std::endl;
-				of << "layout = qc_transpiled._layout" << std::endl;
-				of << "virtual_bits = layout.get_virtual_bits()" << std::endl;
-
-				of << "f = open(\"circuit" << R"(_transpiled.qasm", "w"))" << std::endl;
-				of << R"(f.write("// i"))" << std::endl;
-				of << "for qubit in " << DEFAULT_QREG << ":" << std::endl;
-				of << '\t' << R"(f.write(" " + str(virtual_bits[qubit])))" << std::endl;
-				if (nancillae > 0) {
-					of << "for qubit in " << DEFAULT_ANCREG << ":" << std::endl;
-					of << '\t' << R"(f.write(" " + str(virtual_bits[qubit])))" << std::endl;
-				}
-				if (max_controls > 2) {
-					of << "for qubit in " << DEFAULT_MCTREG << ":" << std::endl;
-					of << '\t' << R"(f.write(" " + str(virtual_bits[qubit])))" << std::endl;
-				}
-				if (totalQubits < narchitecture) {
-					of << "for reg in layout.get_registers():" << std::endl;
-					of << '\t' << "if reg.name is 'ancilla':" << std::endl;
-					of << "\t\t" << "for qubit in reg:" << std::endl;
-					of << "\t\t\t" << R"(f.write(" " + str(virtual_bits[qubit])))" << std::endl;
-				}
-				of << R"(f.write("\n"))" << std::endl;
-				of << "dag = circuit_to_dag(qc_transpiled)" << std::endl;
-				of << "out = [item for sublist in list(dag.layers())[-1]['partition'] for item in sublist]" << std::endl;
-				of << R"(f.write("// o"))" << std::endl;
-				of << "for qubit in out:" << std::endl;
-				of << '\t' << R"(f.write(" " + str(qubit.index)))" << std::endl;
-				of << R"(f.write("\n"))" << std::endl;
-				// remove measurements again
-				of << "qc_transpiled = dag_to_circuit(RemoveFinalMeasurements().run(dag))" << std::endl;
-				of << "f.write(qc_transpiled.qasm())" << std::endl;
-				of << "f.close()" << std::endl;
+				dumpQiskit(of);
 				break;
 		}
 	}
 
+	void QuantumComputation::dumpQiskit(std::ostream& of, unsigned int nthreads) {
+		// TODO: improve/modernize Qiskit dump
+		unsigned short totalQubits = nqubits + nancillae + (max_controls >= 2? max_controls-2: 0);
+		if (totalQubits > 53) {
+			std::cerr << "No more than 53 total qubits are currently supported" << std::endl;
+			return;
+		}
+
+		// For the moment all registers are fused together into for simplicity
+		// This may be adapted in the future
+		of << "from qiskit import *" << '\n';
+		of << "from qiskit.test.mock import ";
+		unsigned short narchitecture = 0;
+		if (totalQubits <= 5) {
+			of << "FakeBurlington";
+			narchitecture = 5;
+		} else if (totalQubits <= 20) {
+			of << "FakeBoeblingen";
+			narchitecture = 20;
+		} else if (totalQubits <= 53) {
+			of << "FakeRochester";
+			narchitecture = 53;
+		}
+		of << '\n';
+		of << "from qiskit.converters import circuit_to_dag, dag_to_circuit" << '\n';
+		of << "from qiskit.transpiler.passes import *" << '\n';
+		of << "from math import pi" << "\n\n";
+
+		of << DEFAULT_QREG << " = QuantumRegister(" << nqubits << ", '" << DEFAULT_QREG << "')" << '\n';
+		if (nclassics > 0) {
+			of << DEFAULT_CREG << " = ClassicalRegister(" << nclassics << ", '" << DEFAULT_CREG << "')" << '\n';
+		}
+		if (nancillae > 0) {
+			of << DEFAULT_ANCREG << " = QuantumRegister(" << nancillae << ", '" << DEFAULT_ANCREG << "')" << '\n';
+		}
+		if (max_controls > 2) {
+			of << DEFAULT_MCTREG << " = QuantumRegister(" << max_controls - 2 << ", '"<< DEFAULT_MCTREG << "')" << '\n';
+		}
+		of << "qc = QuantumCircuit(";
+		of << DEFAULT_QREG;
+		if (nclassics > 0) {
+			of << ", " << DEFAULT_CREG;
+		}
+		if (nancillae > 0) {
+			of << ", " << DEFAULT_ANCREG;
+		}
+		if(max_controls > 2) {
+			of << ", " << DEFAULT_MCTREG;
+		}
+		of << ")" << "\n\n";
+
+		regnames_t qregnames{};
+		regnames_t cregnames{};
+		regnames_t ancregnames{};
+		create_reg_array({}, qregnames, nqubits, DEFAULT_QREG);
+		create_reg_array({}, cregnames, nclassics, DEFAULT_CREG);
+		create_reg_array({}, ancregnames, nancillae, DEFAULT_ANCREG);
+
+		for (auto& ancregname: ancregnames)
+			qregnames.push_back(ancregname);
+
+		dumpOperations(of, nthreads, [&](const Operation& op, std::ostream& os) {
+			op.dumpQiskit(os, qregnames, cregnames, DEFAULT_MCTREG);
+		});
+		// add measurement for determining output mapping
+		of << "qc.measure_all()" << '\n';
+
+		of << "qc_transpiled = transpile(qc, backend=";
+		if (totalQubits <= 5) {
+			of << "FakeBurlington";
+		} else if (totalQubits <= 20) {
+			of << "FakeBoeblingen";
+		} else if (totalQubits <= 53) {
+			of << "FakeRochester";
+		}
+		of << "(), optimization_level=1)" << "\n\n";
+		of << "layout = qc_transpiled._layout" << '\n';
+		of << "virtual_bits = layout.get_virtual_bits()" << '\n';
+
+		of << "f = open(\"circuit" << R"(_transpiled.qasm", "w"))" << '\n';
+		of << R"(f.write("// i"))" << '\n';
+		of << "for qubit in " << DEFAULT_QREG << ":" << '\n';
+		of << '\t' << R"(f.write(" " + str(virtual_bits[qubit])))" << '\n';
+		if (nancillae > 0) {
+			of << "for qubit in " << DEFAULT_ANCREG << ":" << '\n';
+			of << '\t' << R"(f.write(" " + str(virtual_bits[qubit])))" << '\n';
+		}
+		if (max_controls > 2) {
+			of << "for qubit in " << DEFAULT_MCTREG << ":" << '\n';
+			of << '\t' << R"(f.write(" " + str(virtual_bits[qubit])))" << '\n';
+		}
+		if (totalQubits < narchitecture) {
+			of << "for reg in layout.get_registers():" << '\n';
+			of << '\t' << "if reg.name is 'ancilla':" << '\n';
+			of << "\t\t" << "for qubit in reg:" << '\n';
+			of << "\t\t\t" << R"(f.write(" " + str(virtual_bits[qubit])))" << '\n';
+		}
+		of << R"(f.write("\n"))" << '\n';
+		of << "dag = circuit_to_dag(qc_transpiled)" << '\n';
+		of << "out = [item for sublist in list(dag.layers())[-1]['partition'] for item in sublist]" << '\n';
+		of << R"(f.write("// o"))" << '\n';
+		of << "for qubit in out:" << '\n';
+		of << '\t' << R"(f.write(" " + str(qubit.index)))" << '\n';
+		of << R"(f.write("\n"))" << '\n';
+		// remove measurements again
+		of << "qc_transpiled = dag_to_circuit(RemoveFinalMeasurements().run(dag))" << '\n';
+		of << "f.write(qc_transpiled.qasm())" << '\n';
+		of << "f.close()" << '\n';
+	}
+
 	bool QuantumComputation::isIdleQubit(unsigned short physical_qubit) {
 		for(const auto& op:ops) {
 			if (op->actsOn(physical_qubit))
@@ -0,0 +1,166 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#include "SimulationSession.hpp"
+#include "StateSampler.hpp"
+
+namespace qc {
+	SimulationSession::SimulationSession(unsigned short nqubits, dd::DynamicReorderingStrategy strategy): dd(std::make_unique<dd::Package>()), nqubits(nqubits), strategy(strategy) {
+		if (nqubits == 0 || nqubits > MAX_QUBITS) {
+			throw QFRException("[SimulationSession] Number of qubits has to be in [1, " + std::to_string(MAX_QUBITS) + "]");
+		}
+		line.fill(LINE_DEFAULT);
+		varMap = Operation::standardPermutation;
+		dd->setMode(dd::Vector);
+		reset();
+	}
+
+	SimulationSession::~SimulationSession() {
+		releaseCheckpoints();
+		dd->decRef(state);
+	}
+
+	void SimulationSession::reset() {
+		reset(dd->makeZeroState(nqubits));
+	}
+
+	void SimulationSession::reset(const dd::Edge& in) {
+		auto e = in;
+		dd->incRef(e);
+		if (state.p != nullptr) {
+			dd->decRef(state);
+		}
+		state = e;
+		permutation = Operation::standardPermutation;
+		nops = 0;
+		collectGarbage(true);
+	}
+
+	void SimulationSession::multiply(const Operation& op) {
+		if (!op.isUnitary()) {
+			switch (op.getType()) {
+				case Barrier:
+				case Snapshot:
+				case ShowProbabilities:
+					return;
+				default:
+					throw QFRException("[SimulationSession] Operation " + std::string(op.getName()) + " is not supported");
+			}
+		}
+		if (op.getNqubits() > nqubits) {
+			throw QFRException("[SimulationSession] Operation acts on more than " + std::to_string(nqubits) + " qubits");
+		}
+
+		auto tmp = dd->multiply(op.getDD2(dd, line, permutation, varMap), state);
+		dd->incRef(tmp);
+		dd->decRef(state);
+		state = tmp;
+		++nops;
+		++sinceGC;
+
+		if (reorderInterval > 0 && ++sinceReorder >= reorderInterval) {
+			reorder();
+		}
+	}
+
+	void SimulationSession::collectGarbage(bool force) {
+		if (force || (gcInterval > 0 && sinceGC >= gcInterval)) {
+			dd->garbageCollect();
+			sinceGC = 0;
+		}
+	}
+
+	void SimulationSession::apply(const Operation& op) {
+		multiply(op);
+		collectGarbage(false);
+	}
+
+	void SimulationSession::applyBatch(const std::vector<std::unique_ptr<Operation>>& ops) {
+		for (const auto& op: ops) {
+			multiply(*op);
+			collectGarbage(false);
+		}
+		collectGarbage(true);
+	}
+
+	void SimulationSession::applyBatch(const QuantumComputation& qc) {
+		if (qc.getNqubits() > nqubits) {
+			throw QFRException("[SimulationSession] Circuit acts on more than " + std::to_string(nqubits) + " qubits");
+		}
+		for (const auto& op: qc) {
+			multiply(*op);
+			collectGarbage(false);
+		}
+		collectGarbage(true);
+	}
+
+	permutationMap SimulationSession::currentVariables() const {
+		permutationMap current{};
+		for (unsigned short q = 0; q < nqubits; ++q) {
+			current[q] = varMap.at(permutation.at(q));
+		}
+		return current;
+	}
+
+	void SimulationSession::checkQubit(unsigned short q) const {
+		if (q >= nqubits) {
+			throw QFRException("[SimulationSession] Qubit " + std::to_string(q) + " out of range");
+		}
+	}
+
+	fp SimulationSession::probability(unsigned short q) const {
+		checkQubit(q);
+		const auto probabilities = QuantumComputation::getMarginalProbabilities(state, {q}, currentVariables());
+		const auto norm = probabilities[0] + probabilities[1];
+		if (norm < dd::ComplexNumbers::TOLERANCE) {
+			throw QFRException("[SimulationSession] State is the zero vector");
+		}
+		return probabilities[1] / norm;
+	}
+
+	std::vector<fp> SimulationSession::probabilities(const std::vector<unsigned short>& qubits) const {
+		for (const auto q: qubits) {
+			checkQubit(q);
+		}
+		return QuantumComputation::getMarginalProbabilities(state, qubits, currentVariables());
+	}
+
+	std::map<std::string, std::size_t> SimulationSession::sample(std::size_t shots, unsigned int nthreads, std::uint64_t seed) const {
+		const StateSampler sampler(state, nqubits, currentVariables());
+		return sampler.sample(shots, nthreads, seed);
+	}
+
+	std::size_t SimulationSession::checkpoint() {
+		dd->incRef(state);
+		checkpoints.push_back({state, permutation, nops});
+		return checkpoints.size() - 1;
+	}
+
+	void SimulationSession::restore(std::size_t id) {
+		if (id >= checkpoints.size()) {
+			throw QFRException("[SimulationSession] Unknown checkpoint " + std::to_string(id));
+		}
+		const auto& c = checkpoints[id];
+		auto e = c.state;
+		dd->incRef(e);
+		dd->decRef(state);
+		state = e;
+		permutation = c.permutation;
+		nops = c.nops;
+	}
+
+	void SimulationSession::releaseCheckpoints() {
+		for (auto& c: checkpoints) {
+			dd->decRef(c.state);
+		}
+		checkpoints.clear();
+		collectGarbage(true);
+	}
+
+	void SimulationSession::reorder() {
+		state = dd->dynamicReorder(state, varMap, strategy);
+		sinceReorder = 0;
+	}
+}
@@ -0,0 +1,515 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#include "StabilizerSimulator.hpp"
+
+#include <bitset>
+#include <cctype>
+
+namespace qc {
+	namespace {
+		inline long popcount(std::uint64_t v) {
+			return static_cast<long>(std::bitset<64>(v).count());
+		}
+
+		// (x2, z2) := (x1, z1) * (x2, z2) and returns the sum of the exponents of i contributed by all qubits, i.e., the
+		// function g of Aaronson and Gottesman summed over all qubits (evaluated for 64 qubits at once)
+		long multiply(const std::uint64_t* x1, const std::uint64_t* z1, std::uint64_t* x2, std::uint64_t* z2, std::size_t nwords) {
+			long sum = 0;
+			for (std::size_t w = 0; w < nwords; ++w) {
+				const auto a = x1[w];
+				const auto b = z1[w];
+				const auto c = x2[w];
+				const auto d = z2[w];
+				// Y * Z = iX, Y * X = -iZ, X * Y = iZ, X * Z = -iY, Z * X = iY, Z * Y = -iX
+				const auto plus  = (a & b & d & ~c) | (a & ~b & c & d) | (~a & b & c & ~d);
+				const auto minus = (a & b & c & ~d) | (a & ~b & ~c & d) | (~a & b & c & d);
+				sum += popcount(plus) - popcount(minus);
+				x2[w] ^= a;
+				z2[w] ^= b;
+			}
+			return sum;
+		}
+
+		bool anticommutes(const std::uint64_t* x1, const std::uint64_t* z1, const std::uint64_t* x2, const std::uint64_t* z2, std::size_t nwords) {
+			std::uint64_t parity = 0;
+			for (std::size_t w = 0; w < nwords; ++w) {
+				parity ^= (x1[w] & z2[w]) ^ (z1[w] & x2[w]);
+			}
+			return popcount(parity) % 2 == 1;
+		}
+	}
+
+	StabilizerSimulator::StabilizerSimulator(unsigned short nqubits, std::uint64_t seed): nqubits(nqubits), nwords((nqubits + 63u) / 64u), rng(seed) {
+		if (nqubits == 0) {
+			throw QFRException("[StabilizerSimulator] Number of qubits has to be positive");
+		}
+		const std::size_t rows = 2u * nqubits + 1u;
+		xs.resize(rows * nwords);
+		zs.resize(rows * nwords);
+		rs.resize(rows);
+		reset();
+	}
+
+	bool StabilizerSimulator::isClifford(const Operation& op) {
+		if (op.isCompoundOperation()) {
+			// the gates of matrix operations are not necessarily available
+			if (dynamic_cast<const MatrixOperation*>(&op) != nullptr) {
+				return false;
+			}
+			const auto& compound = dynamic_cast<const CompoundOperation&>(op);
+			return std::all_of(compound.begin(), compound.end(), [](const std::unique_ptr<Operation>& o) { return isClifford(*o); });
+		}
+		if (op.isClassicControlledOperation()) {
+			return false;
+		}
+
+		switch (op.getType()) {
+			case Measure:
+			case Reset:
+			case Barrier:
+			case Snapshot:
+			case ShowProbabilities:
+				return op.isNonUnitaryOperation();
+			default:
+				break;
+		}
+		if (!op.isStandardOperation()) {
+			return false;
+		}
+
+		const auto ncontrols = op.getControls().size();
+		switch (op.getType()) {
+			case I:
+				return true;
+			case H:
+			case S:
+			case Sdag:
+			case V:
+			case Vdag:
+				return ncontrols == 0;
+			case X:
+			case Y:
+			case Z:
+				return ncontrols == 0 || (ncontrols == 1 && op.getTargets().size() == 1);
+			case SWAP:
+				return ncontrols == 0;
+			default:
+				return false;
+		}
+	}
+
+	bool StabilizerSimulator::isClifford(const QuantumComputation& qc) {
+		return std::all_of(qc.begin(), qc.end(), [](const std::unique_ptr<Operation>& op) { return isClifford(*op); });
+	}
+
+	void StabilizerSimulator::reset() {
+		std::fill(xs.begin(), xs.end(), 0);
+		std::fill(zs.begin(), zs.end(), 0);
+		std::fill(rs.begin(), rs.end(), 0);
+		for (unsigned short q = 0; q < nqubits; ++q) {
+			const auto mask = 1ull << (q % 64);
+			xrow(q)[q / 64] = mask;
+			zrow(nqubits + q)[q / 64] = mask;
+		}
+	}
+
+	void StabilizerSimulator::setState(const StabilizerSimulator& other) {
+		if (other.nqubits != nqubits) {
+			throw QFRException("[StabilizerSimulator] Number of qubits does not match");
+		}
+		xs = other.xs;
+		zs = other.zs;
+		rs = other.rs;
+	}
+
+	void StabilizerSimulator::checkQubit(unsigned short q) const {
+		if (q >= nqubits) {
+			throw QFRException("[StabilizerSimulator] Qubit " + std::to_string(q) + " out of range");
+		}
+	}
+
+	void StabilizerSimulator::clearRow(std::size_t row) {
+		std::fill(xrow(row), xrow(row) + nwords, 0);
+		std::fill(zrow(row), zrow(row) + nwords, 0);
+		rs[row] = 0;
+	}
+
+	void StabilizerSimulator::rowsum(std::size_t h, std::size_t i) {
+		const auto sum = 2 * (rs[h] + rs[i]) + multiply(xrow(i), zrow(i), xrow(h), zrow(h), nwords);
+		rs[h] = (((sum % 4) + 4) % 4 == 2) ? 1 : 0;
+	}
+
+	void StabilizerSimulator::h(unsigned short q) {
+		checkQubit(q);
+		const auto w = q / 64;
+		const auto mask = 1ull << (q % 64);
+		for (std::size_t row = 0; row < 2u * nqubits; ++row) {
+			auto& xw = xrow(row)[w];
+			auto& zw = zrow(row)[w];
+			if ((xw & mask) && (zw & mask)) {
+				rs[row] ^= 1u;
+			}
+			if (((xw ^ zw) & mask) != 0) {
+				xw ^= mask;
+				zw ^= mask;
+			}
+		}
+	}
+
+	void StabilizerSimulator::s(unsigned short q) {
+		checkQubit(q);
+		const auto w = q / 64;
+		const auto mask = 1ull << (q % 64);
+		for (std::size_t row = 0; row < 2u * nqubits; ++row) {
+			auto& xw = xrow(row)[w];
+			auto& zw = zrow(row)[w];
+			if ((xw & mask) && (zw & mask)) {
+				rs[row] ^= 1u;
+			}
+			zw ^= xw & mask;
+		}
+	}
+
+	void StabilizerSimulator::sdag(unsigned short q) {
+		checkQubit(q);
+		const auto w = q / 64;
+		const auto mask = 1ull << (q % 64);
+		for (std::size_t row = 0; row < 2u * nqubits; ++row) {
+			auto& xw = xrow(row)[w];
+			auto& zw = zrow(row)[w];
+			if ((xw & mask) && !(zw & mask)) {
+				rs[row] ^= 1u;
+			}
+			zw ^= xw & mask;
+		}
+	}
+
+	void StabilizerSimulator::x(unsigned short q) {
+		checkQubit(q);
+		for (std::size_t row = 0; row < 2u * nqubits; ++row) {
+			rs[row] ^= static_cast<unsigned char>(zbit(row, q));
+		}
+	}
+
+	void StabilizerSimulator::y(unsigned short q) {
+		checkQubit(q);
+		for (std::size_t row = 0; row < 2u * nqubits; ++row) {
+			rs[row] ^= static_cast<unsigned char>(xbit(row, q) != zbit(row, q));
+		}
+	}
+
+	void StabilizerSimulator::z(unsigned short q) {
+		checkQubit(q);
+		for (std::size_t row = 0; row < 2u * nqubits; ++row) {
+			rs[row] ^= static_cast<unsigned char>(xbit(row, q));
+		}
+	}
+
+	void StabilizerSimulator::cx(unsigned short control, unsigned short target) {
+		checkQubit(control);
+		checkQubit(target);
+		if (control == target) {
+			throw QFRException("[StabilizerSimulator] Control and target have to be distinct");
+		}
+		const auto wc = control / 64;
+		const auto mc = 1ull << (control % 64);
+		const auto wt = target / 64;
+		const auto mt = 1ull << (target % 64);
+		for (std::size_t row = 0; row < 2u * nqubits; ++row) {
+			auto* xr = xrow(row);
+			auto* zr = zrow(row);
+			const bool xc = xr[wc] & mc;
+			const bool zc = zr[wc] & mc;
+			const bool xt = xr[wt] & mt;
+			const bool zt = zr[wt] & mt;
+			if (xc && zt && (xt == zc)) {
+				rs[row] ^= 1u;
+			}
+			if (xc) {
+				xr[wt] ^= mt;
+			}
+			if (zt) {
+				zr[wc] ^= mc;
+			}
+		}
+	}
+
+	void StabilizerSimulator::cz(unsigned short a, unsigned short b) {
+		h(b);
+		cx(a, b);
+		h(b);
+	}
+
+	void StabilizerSimulator::swap(unsigned short a, unsigned short b) {
+		checkQubit(a);
+		checkQubit(b);
+		if (a == b) {
+			return;
+		}
+		const auto wa = a / 64;
+		const auto ma = 1ull << (a % 64);
+		const auto wb = b / 64;
+		const auto mb = 1ull << (b % 64);
+		for (std::size_t row = 0; row < 2u * nqubits; ++row) {
+			for (auto* r: {xrow(row), zrow(row)}) {
+				if (static_cast<bool>(r[wa] & ma) != static_cast<bool>(r[wb] & mb)) {
+					r[wa] ^= ma;
+					r[wb] ^= mb;
+				}
+			}
+		}
+	}
+
+	std::size_t StabilizerSimulator::findRandomRow(unsigned short q) const {
+		for (std::size_t row = nqubits; row < 2u * nqubits; ++row) {
+			if (xbit(row, q)) {
+				return row;
+			}
+		}
+		return 2u * nqubits;
+	}
+
+	bool StabilizerSimulator::isDeterministic(unsigned short q) const {
+		checkQubit(q);
+		return findRandomRow(q) == 2u * nqubits;
+	}
+
+	bool StabilizerSimulator::measure(unsigned short q) {
+		return measure(q, isDeterministic(q) ? false : (rng() & 1u) != 0);
+	}
+
+	bool StabilizerSimulator::measure(unsigned short q, bool outcome) {
+		checkQubit(q);
+		const std::size_t scratch = 2u * nqubits;
+		const auto p = findRandomRow(q);
+		if (p < scratch) {
+			for (std::size_t row = 0; row < scratch; ++row) {
+				if (row != p && xbit(row, q)) {
+					rowsum(row, p);
+				}
+			}
+			std::copy(xrow(p), xrow(p) + nwords, xrow(p - nqubits));
+			std::copy(zrow(p), zrow(p) + nwords, zrow(p - nqubits));
+			rs[p - nqubits] = rs[p];
+			clearRow(p);
+			zrow(p)[q / 64] = 1ull << (q % 64);
+			rs[p] = outcome ? 1 : 0;
+			return outcome;
+		}
+
+		// the outcome is determined by the product of the stabilizers whose destabilizers anticommute with Z_q
+		clearRow(scratch);
+		for (std::size_t row = 0; row < nqubits; ++row) {
+			if (xbit(row, q)) {
+				rowsum(scratch, row + nqubits);
+			}
+		}
+		return rs[scratch] != 0;
+	}
+
+	void StabilizerSimulator::reset(unsigned short q) {
+		if (measure(q)) {
+			x(q);
+		}
+	}
+
+	std::string StabilizerSimulator::measureAll() {
+		StabilizerSimulator copy(*this);
+		std::string result(nqubits, '0');
+		for (unsigned short q = 0; q < nqubits; ++q) {
+			if (copy.measure(q)) {
+				result[nqubits - 1 - q] = '1';
+			}
+		}
+		rng = copy.rng;
+		return result;
+	}
+
+	std::map<std::string, std::size_t> StabilizerSimulator::sample(std::size_t shots) {
+		std::map<std::string, std::size_t> counts{};
+		for (std::size_t shot = 0; shot < shots; ++shot) {
+			++counts[measureAll()];
+		}
+		return counts;
+	}
+
+	void StabilizerSimulator::apply(const Operation& op, std::vector<bool>& cbits) {
+		if (op.isCompoundOperation() && dynamic_cast<const MatrixOperation*>(&op) == nullptr) {
+			for (const auto& o: dynamic_cast<const CompoundOperation&>(op)) {
+				apply(*o, cbits);
+			}
+			return;
+		}
+		if (!isClifford(op)) {
+			throw QFRException("[StabilizerSimulator] Operation " + std::string(op.getName()) + " is not supported");
+		}
+
+		const auto& targets = op.getTargets();
+		switch (op.getType()) {
+			case Measure:
+				// the i-th qubit is measured into the i-th classical bit
+				for (std::size_t i = 0; i < op.getControls().size(); ++i) {
+					cbits.at(targets.at(i)) = measure(op.getControls()[i].qubit);
+				}
+				return;
+			case Reset:
+				for (const auto q: targets) {
+					reset(q);
+				}
+				return;
+			case Barrier:
+			case Snapshot:
+			case ShowProbabilities:
+			case I:
+				return;
+			case SWAP:
+				swap(targets.at(0), targets.at(1));
+				return;
+			default:
+				break;
+		}
+
+		if (!op.getControls().empty()) {
+			const auto control = op.getControls().front();
+			const auto target = targets.front();
+			if (control.type == Control::neg) {
+				x(control.qubit);
+			}
+			switch (op.getType()) {
+				case X:
+					cx(control.qubit, target);
+					break;
+				case Y:
+					// CY = S_t CX Sdag_t
+					sdag(target);
+					cx(control.qubit, target);
+					s(target);
+					break;
+				default:
+					cz(control.qubit, target);
+					break;
+			}
+			if (control.type == Control::neg) {
+				x(control.qubit);
+			}
+			return;
+		}
+
+		for (const auto t: targets) {
+			switch (op.getType()) {
+				case H: h(t); break;
+				case X: x(t); break;
+				case Y: y(t); break;
+				case Z: z(t); break;
+				case S: s(t); break;
+				case Sdag: sdag(t); break;
+				// V = H S H and Vdag = H Sdag H (up to a global phase)
+				case V: h(t); s(t); h(t); break;
+				case Vdag: h(t); sdag(t); h(t); break;
+				default: break;
+			}
+		}
+	}
+
+	std::vector<bool> StabilizerSimulator::run(const QuantumComputation& qc) {
+		if (qc.getNqubits() > nqubits) {
+			throw QFRException("[StabilizerSimulator] Circuit acts on more than " + std::to_string(nqubits) + " qubits");
+		}
+		std::vector<bool> cbits(qc.getNcbits(), false);
+		for (const auto& op: qc) {
+			apply(*op, cbits);
+		}
+		return cbits;
+	}
+
+	void StabilizerSimulator::parsePauli(const std::string& pauli, std::vector<std::uint64_t>& px, std::vector<std::uint64_t>& pz) const {
+		if (pauli.size() != nqubits) {
+			throw QFRException("[StabilizerSimulator] Pauli string has to be of length " + std::to_string(nqubits));
+		}
+		px.assign(nwords, 0);
+		pz.assign(nwords, 0);
+		for (unsigned short q = 0; q < nqubits; ++q) {
+			const auto p = static_cast<char>(std::toupper(pauli[nqubits - 1 - q]));
+			const auto mask = 1ull << (q % 64);
+			switch (p) {
+				case 'I': break;
+				case 'X': px[q / 64] |= mask; break;
+				case 'Z': pz[q / 64] |= mask; break;
+				case 'Y':
+					px[q / 64] |= mask;
+					pz[q / 64] |= mask;
+					break;
+				default:
+					throw QFRException("[StabilizerSimulator] Invalid Pauli operator " + std::string(1, pauli[nqubits - 1 - q]));
+			}
+		}
+	}
+
+	fp StabilizerSimulator::expectation(const std::string& pauli) const {
+		std::vector<std::uint64_t> px{};
+		std::vector<std::uint64_t> pz{};
+		parsePauli(pauli, px, pz);
+
+		// the expectation value vanishes unless the Pauli string is (up to its sign) an element of the stabilizer group
+		for (std::size_t row = nqubits; row < 2u * nqubits; ++row) {
+			if (anticommutes(xrow(row), zrow(row), px.data(), pz.data(), nwords)) {
+				return 0.;
+			}
+		}
+
+		// the string is the product of the stabilizers whose destabilizers anticommute with it
+		std::vector<std::uint64_t> sx(nwords, 0);
+		std::vector<std::uint64_t> sz(nwords, 0);
+		long sum = 0;
+		for (std::size_t row = 0; row < nqubits; ++row) {
+			if (anticommutes(xrow(row), zrow(row), px.data(), pz.data(), nwords)) {
+				sum += 2 * rs[row + nqubits] + multiply(xrow(row + nqubits), zrow(row + nqubits), sx.data(), sz.data(), nwords);
+			}
+		}
+		return (((sum % 4) + 4) % 4 == 0) ? 1. : -1.;
+	}
+
+	dd::Edge StabilizerSimulator::toDD(std::unique_ptr<dd::Package>& dd) const {
+		if (nqubits > dd::MAXN) {
+			throw QFRException("[StabilizerSimulator] Too many qubits for a DD");
+		}
+
+		// a basis state contained in the stabilizer state (random measurements are forced to yield 0)
+		StabilizerSimulator copy(*this);
+		std::bitset<dd::MAXN> basis{};
+		for (unsigned short q = 0; q < nqubits; ++q) {
+			basis[q] = copy.measure(q, false);
+		}
+
+		// project the basis state onto the stabilizer state, i.e., apply (I + S) for every stabilizer S
+		dd->setMode(dd::Vector);
+		dd::Edge e = dd->makeBasisState(nqubits, basis);
+		std::array<short, MAX_QUBITS> line{};
+		line.fill(LINE_DEFAULT);
+		for (std::size_t row = nqubits; row < 2u * nqubits; ++row) {
+			dd::Edge applied = e;
+			for (unsigned short q = 0; q < nqubits; ++q) {
+				const auto xq = xbit(row, q);
+				const auto zq = zbit(row, q);
+				if (!xq && !zq) {
+					continue;
+				}
+				line[q] = LINE_TARGET;
+				applied = dd->multiply(dd->makeGateDD(xq ? (zq ? Ymat : Xmat) : Zmat, nqubits, line), applied);
+				line[q] = LINE_DEFAULT;
+			}
+			if (rs[row] != 0) {
+				applied.w = dd->cn.lookup(-CN::val(applied.w.r), -CN::val(applied.w.i));
+			}
+			e = dd->add(e, applied);
+		}
+
+		const auto norm = QuantumComputation::getMarginalProbabilities(e, {}, Operation::standardPermutation).front();
+		const auto factor = 1. / std::sqrt(norm);
+		e.w = dd->cn.lookup(CN::val(e.w.r) * factor, CN::val(e.w.i) * factor);
+		return e;
+	}
+}
@@ -0,0 +1,100 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#include "StateSampler.hpp"
+
+namespace qc {
+	StateSampler::StateSampler(const dd::Edge& state, unsigned short nqubits, const permutationMap& varMap): root(state), nqubits(nqubits) {
+		qubitAt.assign(nqubits, 0);
+		std::vector<bool> used(nqubits, false);
+		for (unsigned short q = 0; q < nqubits; ++q) {
+			const auto it = varMap.find(q);
+			if (it == varMap.end() || it->second >= nqubits || used[it->second]) {
+				throw QFRException("[StateSampler] Variable order has to assign distinct variables in [0, " + std::to_string(nqubits) + ") to all qubits");
+			}
+			used[it->second] = true;
+			qubitAt[it->second] = q;
+		}
+		if (!dd::Package::isTerminal(root) && root.p->v >= nqubits) {
+			throw QFRException("[StateSampler] State has more than " + std::to_string(nqubits) + " qubits");
+		}
+
+		std::unordered_map<dd::NodePtr, fp> norms{};
+		norm = computeNorm(root, norms);
+		if (norm < dd::ComplexNumbers::TOLERANCE) {
+			throw QFRException("[StateSampler] Cannot sample from the zero vector");
+		}
+	}
+
+	fp StateSampler::computeNorm(const dd::Edge& e, std::unordered_map<dd::NodePtr, fp>& norms) {
+		const auto w = CN::mag2(e.w);
+		if (w == 0. || dd::Package::isTerminal(e)) {
+			return w;
+		}
+
+		const auto it = norms.find(e.p);
+		if (it != norms.end()) {
+			return w * it->second;
+		}
+
+		// the successors of vector nodes reside at the edges 0 (|0>) and 2 (|1>)
+		const auto zero = computeNorm(e.p->e[0], norms);
+		const auto one = computeNorm(e.p->e[2], norms);
+		const auto sum = zero + one;
+		norms[e.p] = sum;
+		probabilityOfOne[e.p] = sum > 0. ? one / sum : 0.;
+		return w * sum;
+	}
+
+	std::string StateSampler::sample(std::mt19937_64& rng) const {
+		std::uniform_real_distribution<fp> dist(0., 1.);
+		std::string result(nqubits, '0');
+		auto e = root;
+		while (!dd::Package::isTerminal(e)) {
+			const bool one = dist(rng) < probabilityOfOne.at(e.p);
+			if (one) {
+				result[nqubits - 1 - qubitAt[static_cast<std::size_t>(e.p->v)]] = '1';
+			}
+			e = e.p->e[one ? 2 : 0];
+		}
+		return result;
+	}
+
+	std::map<std::string, std::size_t> StateSampler::sample(std::size_t shots, unsigned int nthreads, std::uint64_t seed) const {
+		nthreads = std::max(1u, static_cast<unsigned int>(std::min<std::size_t>(nthreads, shots)));
+
+		std::vector<std::unordered_map<std::string, std::size_t>> counts(nthreads);
+		auto run = [&](unsigned int t) {
+			std::seed_seq seq{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32u), static_cast<std::uint32_t>(t)};
+			std::mt19937_64 rng(seq);
+			const auto first = shots * t / nthreads;
+			const auto last = shots * (t+1) / nthreads;
+			for (std::size_t i = first; i < last; ++i) {
+				++counts[t][sample(rng)];
+			}
+		};
+
+		if (nthreads == 1) {
+			run(0);
+		} else {
+			std::vector<std::thread> threads{};
+			threads.reserve(nthreads);
+			for (unsigned int t = 0; t < nthreads; ++t) {
+				threads.emplace_back(run, t);
+			}
+			for (auto& thread: threads) {
+				thread.join();
+			}
+		}
+
+		std::map<std::string, std::size_t> result{};
+		for (const auto& c: counts) {
+			for (const auto& entry: c) {
+				result[entry.first] += entry.second;
+			}
+		}
+		return result;
+	}
+}
@@ -0,0 +1,126 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#include "equivalence/MiterBuilder.hpp"
+
+namespace qc {
+	MiterBuilder::MiterBuilder(QuantumComputation& qc1, QuantumComputation& qc2): qc1(qc1), qc2(qc2) {
+		if (qc1.getNqubits() != qc2.getNqubits()) {
+			throw QFRException("[MiterBuilder] Circuits have to act on the same number of qubits");
+		}
+	}
+
+	dd::Edge MiterBuilder::reduce(dd::Edge e, std::unique_ptr<dd::Package>& dd) {
+		auto f = qc1.reduceGarbage(e, dd, true);
+		f = qc2.reduceGarbage(f, dd, false);
+		f = qc1.reduceAncillae(f, dd, true);
+		f = qc2.reduceAncillae(f, dd, false);
+		dd->incRef(f);
+		dd->decRef(e);
+		return f;
+	}
+
+	dd::Edge MiterBuilder::build(std::unique_ptr<dd::Package>& dd) {
+		maxSize = 0;
+		dd->setMode(dd::Matrix);
+		if (qc1.getNqubits() == 0) {
+			result = reference = dd::Package::DDone;
+			return result;
+		}
+
+		std::vector<const Operation*> left{};
+		std::vector<const Operation*> right{};
+		for (const auto& op: qc1) {
+			left.emplace_back(op.get());
+		}
+		for (const auto& op: qc2) {
+			right.emplace_back(op.get());
+		}
+
+		std::array<short, MAX_QUBITS> line{};
+		line.fill(LINE_DEFAULT);
+		auto map1 = qc1.initialLayout;
+		auto map2 = qc2.initialLayout;
+
+		auto e = qc1.createInitialMatrix(dd);
+		maxSize = static_cast<std::size_t>(dd->size(e));
+
+		auto applyLeft = [&](const dd::Edge& current, permutationMap& map, std::size_t i) {
+			return dd->multiply(left[i]->getDD(dd, line, map), current);
+		};
+		auto applyRight = [&](const dd::Edge& current, permutationMap& map, std::size_t j) {
+			return dd->multiply(current, right[j]->getInverseDD(dd, line, map));
+		};
+
+		std::size_t i = 0;
+		std::size_t j = 0;
+		while (i < left.size() || j < right.size()) {
+			dd::Edge tmp{};
+			bool fromLeft = false;
+			if (j == right.size()) {
+				fromLeft = true;
+			} else if (i < left.size()) {
+				switch (strategy) {
+					case MiterStrategy::Naive:
+						fromLeft = (i <= j);
+						break;
+					case MiterStrategy::Proportional:
+						fromLeft = (i * right.size() <= j * left.size());
+						break;
+					case MiterStrategy::Lookahead: {
+						// try both gates and keep the smaller result
+						auto leftMap = map1;
+						auto candidate = applyLeft(e, leftMap, i);
+						dd->incRef(candidate);
+						auto rightMap = map2;
+						tmp = applyRight(e, rightMap, j);
+						if (dd->size(candidate) <= dd->size(tmp)) {
+							tmp = candidate;
+							map1 = leftMap;
+							++i;
+						} else {
+							map2 = rightMap;
+							dd->incRef(tmp);
+							dd->decRef(candidate);
+							++j;
+						}
+						dd->decRef(e);
+						e = tmp;
+						maxSize = std::max(maxSize, static_cast<std::size_t>(dd->size(e)));
+						dd->garbageCollect();
+						continue;
+					}
+				}
+			}
+
+			if (fromLeft) {
+				tmp = applyLeft(e, map1, i++);
+			} else {
+				tmp = applyRight(e, map2, j++);
+			}
+			dd->incRef(tmp);
+			dd->decRef(e);
+			e = tmp;
+			maxSize = std::max(maxSize, static_cast<std::size_t>(dd->size(e)));
+			dd->garbageCollect();
+		}
+
+		// establish the output permutations on the respective side
+		QuantumComputation::changePermutation(e, map1, qc1.outputPermutation, line, dd, true);
+		QuantumComputation::changePermutation(e, map2, qc2.outputPermutation, line, dd, false);
+		result = reduce(e, dd);
+
+		// the identity subject to the same reductions
+		reference = reduce(qc1.createInitialMatrix(dd), dd);
+		return result;
+	}
+
+	bool MiterBuilder::isIdentity() const {
+		if (result.p != reference.p) {
+			return false;
+		}
+		return std::abs(CN::mag2(result.w) - CN::mag2(reference.w)) < dd::ComplexNumbers::TOLERANCE;
+	}
+}
@@ -0,0 +1,221 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#include "equivalence/RandomStimuliChecker.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <complex>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace qc {
+	constexpr fp RandomStimuliChecker::DEFAULT_TOLERANCE;
+
+	namespace {
+		std::complex<fp> weight(const dd::Edge& e) {
+			return {CN::val(e.w.r), CN::val(e.w.i)};
+		}
+
+		// <x|y> without the weights of the incoming edges
+		std::complex<fp> innerProduct(dd::NodePtr x, dd::NodePtr y, std::map<std::pair<dd::NodePtr, dd::NodePtr>, std::complex<fp>>& computed) {
+			if (x->v != y->v) {
+				throw QFRException("[fidelity] States have to consist of the same number of qubits");
+			}
+			const auto it = computed.find({x, y});
+			if (it != computed.end()) {
+				return it->second;
+			}
+
+			// the successors of vector nodes reside at the edges 0 (|0>) and 2 (|1>)
+			std::complex<fp> result{};
+			for (std::size_t k = 0; k <= 2; k += 2) {
+				const auto& a = x->e[k];
+				const auto& b = y->e[k];
+				if (CN::equalsZero(a.w) || CN::equalsZero(b.w)) {
+					continue;
+				}
+				auto product = std::conj(weight(a)) * weight(b);
+				if (!dd::Package::isTerminal(a)) {
+					product *= innerProduct(a.p, b.p, computed);
+				}
+				result += product;
+			}
+			computed[{x, y}] = result;
+			return result;
+		}
+	}
+
+	RandomStimuliChecker::RandomStimuliChecker(QuantumComputation& qc1, QuantumComputation& qc2): qc1(qc1), qc2(qc2) {
+		if (qc1.getNqubits() != qc2.getNqubits()) {
+			throw QFRException("[RandomStimuliChecker] Circuits have to act on the same number of qubits");
+		}
+	}
+
+	fp RandomStimuliChecker::fidelity(const dd::Edge& x, const dd::Edge& y) {
+		if (CN::equalsZero(x.w) || CN::equalsZero(y.w)) {
+			return 0.;
+		}
+		auto product = std::conj(weight(x)) * weight(y);
+		if (!dd::Package::isTerminal(x) || !dd::Package::isTerminal(y)) {
+			if (dd::Package::isTerminal(x) || dd::Package::isTerminal(y)) {
+				throw QFRException("[fidelity] States have to consist of the same number of qubits");
+			}
+			std::map<std::pair<dd::NodePtr, dd::NodePtr>, std::complex<fp>> computed{};
+			product *= innerProduct(x.p, y.p, computed);
+		}
+		return std::norm(product);
+	}
+
+	fp RandomStimuliChecker::fidelity(const std::vector<fp>& p, const std::vector<fp>& q) {
+		if (p.size() != q.size()) {
+			throw QFRException("[fidelity] Distributions have to consist of the same number of outcomes");
+		}
+		fp overlap = 0.;
+		for (std::size_t i = 0; i < p.size(); ++i) {
+			overlap += std::sqrt(p[i] * q[i]);
+		}
+		return overlap * overlap;
+	}
+
+	dd::Edge RandomStimuliChecker::generateStimulus(std::size_t index, std::unique_ptr<dd::Package>& dd, RandomStimuliResult& stimulus) const {
+		std::seed_seq seq{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32u),
+		                  static_cast<std::uint32_t>(index), static_cast<std::uint32_t>(static_cast<std::uint64_t>(index) >> 32u)};
+		std::mt19937_64 rng(seq);
+		const auto n = qc1.getNqubits();
+		const auto ancillae = ancillary();
+
+		if (type == StimuliType::Basis) {
+			std::bernoulli_distribution bit(0.5);
+			std::bitset<dd::MAXN> state{};
+			stimulus.basisState.assign(n, '0');
+			for (unsigned short q = 0; q < n; ++q) {
+				if (!ancillae.test(q) && bit(rng)) {
+					state.set(q);
+					stimulus.basisState[n - 1 - q] = '1';
+				}
+			}
+			return dd->makeBasisState(n, state);
+		}
+
+		// uniformly distributed on the Bloch sphere
+		std::uniform_real_distribution<fp> uniform(0., 1.);
+		stimulus.productState.clear();
+		dd::Edge e = dd::Package::DDone;
+		for (unsigned short q = 0; q < n; ++q) {
+			fp theta = 0.;
+			fp phi = 0.;
+			if (!ancillae.test(q)) {
+				theta = std::acos(1. - 2. * uniform(rng));
+				phi = 2. * PI * uniform(rng);
+			}
+			stimulus.productState.emplace_back(theta, phi);
+
+			const auto w = weight(e);
+			const auto zero = std::cos(theta / 2.) * w;
+			const auto one = std::polar(std::sin(theta / 2.), phi) * w;
+			dd::Edge e0{e.p, dd->cn.lookup(zero.real(), zero.imag())};
+			dd::Edge e1{e.p, dd->cn.lookup(one.real(), one.imag())};
+			if (CN::equalsZero(e0.w)) {
+				e0 = dd::Package::DDzero;
+			}
+			if (CN::equalsZero(e1.w)) {
+				e1 = dd::Package::DDzero;
+			}
+			e = dd->makeNonterminal(static_cast<short>(q), {e0, dd::Package::DDzero, e1, dd::Package::DDzero});
+		}
+		return e;
+	}
+
+	fp RandomStimuliChecker::check(std::size_t index, std::unique_ptr<dd::Package>& dd, RandomStimuliResult& stimulus) const {
+		dd->setMode(dd::Vector);
+		auto in = generateStimulus(index, dd, stimulus);
+		// the stimulus is needed for both simulations
+		dd->incRef(in);
+		auto out1 = qc1.simulate(in, dd);
+		auto out2 = qc2.simulate(in, dd);
+
+		fp f = 0.;
+		const auto garbageOutputs = garbage();
+		if (garbageOutputs.none()) {
+			f = fidelity(out1, out2);
+		} else {
+			// the outputs of both circuits reside at the variables given by their output permutations
+			std::vector<unsigned short> outputs{};
+			for (unsigned short q = 0; q < qc1.getNqubits(); ++q) {
+				if (!garbageOutputs.test(q)) {
+					outputs.push_back(q);
+				}
+			}
+			f = fidelity(QuantumComputation::getMarginalProbabilities(out1, outputs),
+			             QuantumComputation::getMarginalProbabilities(out2, outputs));
+		}
+		dd->decRef(in);
+		dd->decRef(out1);
+		dd->decRef(out2);
+		dd->garbageCollect();
+		return f;
+	}
+
+	RandomStimuliResult RandomStimuliChecker::run() {
+		RandomStimuliResult result{};
+		const auto workers = std::max(1u, std::min(nthreads, static_cast<unsigned int>(maxSimulations)));
+
+		std::atomic<std::size_t> next{0};
+		std::atomic<std::size_t> performed{0};
+		// index of the first counterexample found so far (simulations with a higher index are skipped)
+		std::atomic<std::size_t> counterexample{maxSimulations};
+		std::mutex mutex{};
+		std::vector<std::exception_ptr> errors(workers);
+
+		auto work = [&](unsigned int t) {
+			try {
+				auto dd = std::make_unique<dd::Package>();
+				while (true) {
+					const auto index = next++;
+					if (index >= maxSimulations || index >= counterexample) {
+						break;
+					}
+					RandomStimuliResult stimulus{};
+					const auto f = check(index, dd, stimulus);
+					++performed;
+					if (f < 1. - tolerance) {
+						std::lock_guard<std::mutex> lock(mutex);
+						if (index < counterexample) {
+							counterexample = index;
+							stimulus.equivalent = false;
+							stimulus.fidelity = f;
+							result = std::move(stimulus);
+						}
+					}
+				}
+			} catch (...) {
+				errors[t] = std::current_exception();
+				counterexample = 0;
+			}
+		};
+
+		if (workers == 1) {
+			work(0);
+		} else {
+			std::vector<std::thread> threads{};
+			threads.reserve(workers);
+			for (unsigned int t = 0; t < workers; ++t) {
+				threads.emplace_back(work, t);
+			}
+			for (auto& thread: threads) {
+				thread.join();
+			}
+		}
+		for (auto& error: errors) {
+			if (error)
+				std::rethrow_exception(error);
+		}
+
+		result.simulations = performed;
+		return result;
+	}
+}
@@ -0,0 +1,266 @@
+/*
+ * This file is part of IIC-JKU QFR library which is released under the MIT license.
+ * See file README.md or go to http://iic.jku.at/eda/research/quantum/ for more information.
+ */
+
+#include "operations/MatrixOperation.hpp"
+
+namespace qc {
+	constexpr unsigned short MatrixOperation::MAX_MATRIX_QUBITS;
+
+	void MatrixOperation::setup(const std::vector<unsigned short>& qb) {
+		std::strcpy(name, "Matrix operation:");
+		qubits = qb;
+		std::sort(qubits.begin(), qubits.end());
+		if (qubits.empty() || qubits.size() > MAX_MATRIX_QUBITS) {
+			throw QFRException("[MatrixOperation] Matrix operations have to act on 1 to " + std::to_string(MAX_MATRIX_QUBITS) + " qubits");
+		}
+		if (std::adjacent_find(qubits.begin(), qubits.end()) != qubits.end()) {
+			throw QFRException("[MatrixOperation] Qubits have to be distinct");
+		}
+		if (qubits.back() >= nqubits) {
+			throw QFRException("[MatrixOperation] Qubit " + std::to_string(qubits.back()) + " out of range");
+		}
+		targets = qubits;
+	}
+
+	MatrixOperation::MatrixOperation(unsigned short nq, const std::vector<unsigned short>& qubits, const Matrix& matrix): CompoundOperation(nq), matrix(matrix) {
+		setup(qubits);
+		const std::size_t dim = 1u << MatrixOperation::qubits.size();
+		if (matrix.size() != dim * dim) {
+			throw QFRException("[MatrixOperation] Matrix has to be of size " + std::to_string(dim) + "x" + std::to_string(dim));
+		}
+	}
+
+	MatrixOperation::MatrixOperation(unsigned short nq, const std::vector<unsigned short>& qubits, std::vector<std::unique_ptr<Operation>>&& ops): CompoundOperation(nq) {
+		setup(qubits);
+		const std::size_t dim = 1u << MatrixOperation::qubits.size();
+		matrix.assign(dim * dim, 0);
+		for (std::size_t i = 0; i < dim; ++i) {
+			matrix[i*dim + i] = 1;
+		}
+		for (auto& op: ops) {
+			if (!isSupported(*op)) {
+				throw QFRException("[MatrixOperation] Operation " + std::string(op->getName()) + " cannot be part of a matrix operation");
+			}
+			apply(dynamic_cast<const StandardOperation&>(*op), MatrixOperation::qubits, matrix);
+			emplace_back(op);
+		}
+	}
+
+	std::unique_ptr<Operation> MatrixOperation::clone() const {
+		auto op = std::make_unique<MatrixOperation>(nqubits, qubits, matrix);
+		op->copyAttributes(*this);
+		for (const auto& o: ops) {
+			op->ops.emplace_back(o->clone());
+		}
+		return op;
+	}
+
+	bool MatrixOperation::isSupported(const Operation& op) {
+		if (!op.isStandardOperation()) {
+			return false;
+		}
+		switch (op.getType()) {
+			case iSWAP:
+			case P:
+			case Pdag:
+				return false;
+			case SWAP:
+				// uncontrolled SWAPs are handled by permuting the qubits when building the functionality
+				return !op.getControls().empty();
+			default:
+				return op.getTargets().size() == 1;
+		}
+	}
+
+	void MatrixOperation::apply(const StandardOperation& op, const std::vector<unsigned short>& qubits, Matrix& m) {
+		const std::size_t dim = 1u << qubits.size();
+		auto bit = [&qubits](unsigned short q) -> std::size_t {
+			const auto it = std::lower_bound(qubits.begin(), qubits.end(), q);
+			if (it == qubits.end() || *it != q) {
+				throw QFRException("[MatrixOperation] Operation acts on qubit " + std::to_string(q) + " which is not part of the matrix operation");
+			}
+			return 1u << static_cast<std::size_t>(it - qubits.begin());
+		};
+
+		// rows whose index satisfies (row & mask) == value fulfill all control conditions
+		std::size_t mask = 0;
+		std::size_t value = 0;
+		for (const auto& c: op.getControls()) {
+			mask |= bit(c.qubit);
+			if (c.type == Control::pos) {
+				value |= bit(c.qubit);
+			}
+		}
+
+		if (op.getType() == SWAP) {
+			const auto t0 = bit(op.getTargets().at(0));
+			const auto t1 = bit(op.getTargets().at(1));
+			for (std::size_t row = 0; row < dim; ++row) {
+				if ((row & mask) == value && (row & t0) && !(row & t1)) {
+					std::swap_ranges(m.begin() + static_cast<std::ptrdiff_t>(row*dim),
+					                 m.begin() + static_cast<std::ptrdiff_t>((row+1)*dim),
+					                 m.begin() + static_cast<std::ptrdiff_t>((row ^ t0 ^ t1)*dim));
+				}
+			}
+			return;
+		}
+
+		const auto gm = op.getGateMatrix();
+		std::array<std::complex<fp>, dd::NEDGE> g{};
+		for (std::size_t i = 0; i < dd::NEDGE; ++i) {
+			g[i] = {gm[i].r, gm[i].i};
+		}
+		const auto t = bit(op.getTargets().at(0));
+		for (std::size_t row = 0; row < dim; ++row) {
+			if ((row & mask) != value || (row & t)) {
+				continue;
+			}
+			for (std::size_t col = 0; col < dim; ++col) {
+				const auto a = m[row*dim + col];
+				const auto b = m[(row | t)*dim + col];
+				m[row*dim + col]       = g[0]*a + g[1]*b;
+				m[(row | t)*dim + col] = g[2]*a + g[3]*b;
+			}
+		}
+	}
+
+	dd::Edge MatrixOperation::buildDD(std::unique_ptr<dd::Package>& dd, const std::vector<short>& variables, bool inverse) const {
+		// position of each variable within the matrix operation (or -1 if the operation does not act on it)
+		std::vector<short> blockIndex(nqubits, -1);
+		short lowest = std::numeric_limits<short>::max();
+		for (std::size_t j = 0; j < variables.size(); ++j) {
+			if (variables[j] < 0 || variables[j] >= nqubits) {
+				throw QFRException("[MatrixOperation] Invalid variable " + std::to_string(variables[j]));
+			}
+			blockIndex[static_cast<std::size_t>(variables[j])] = static_cast<short>(j);
+			lowest = std::min(lowest, variables[j]);
+		}
+
+		// all variables below the lowest variable of the block are left unchanged
+		dd::Edge ident = lowest > 0 ? dd->makeIdent(0, static_cast<short>(lowest - 1)) : dd::Package::DDone;
+		return buildDD(dd, blockIndex, ident, lowest, static_cast<short>(nqubits - 1), 0, 0, inverse);
+	}
+
+	dd::Edge MatrixOperation::buildDD(std::unique_ptr<dd::Package>& dd, const std::vector<short>& blockIndex, dd::Edge ident, short lowest, short v, std::size_t row, std::size_t col, bool inverse) const {
+		if (v < lowest) {
+			const std::size_t dim = 1u << qubits.size();
+			const auto entry = inverse ? std::conj(matrix[col*dim + row]) : matrix[row*dim + col];
+			if (std::abs(entry.real()) < dd::ComplexNumbers::TOLERANCE && std::abs(entry.imag()) < dd::ComplexNumbers::TOLERANCE) {
+				return dd::Package::DDzero;
+			}
+			dd::Edge e = ident;
+			e.w = dd->cn.lookup(dd::ComplexValue{entry.real(), entry.imag()});
+			return e;
+		}
+
+		const auto j = blockIndex[static_cast<std::size_t>(v)];
+		std::array<dd::Edge, dd::NEDGE> edges{};
+		if (j < 0) {
+			const auto child = buildDD(dd, blockIndex, ident, lowest, static_cast<short>(v - 1), row, col, inverse);
+			edges = {child, dd::Package::DDzero, dd::Package::DDzero, child};
+		} else {
+			for (std::size_t i = 0; i < 2; ++i) {
+				for (std::size_t k = 0; k < 2; ++k) {
+					edges[2*i + k] = buildDD(dd, blockIndex, ident, lowest, static_cast<short>(v - 1), row | (i << static_cast<std::size_t>(j)), col | (k << static_cast<std::size_t>(j)), inverse);
+				}
+			}
+		}
+		return dd->makeNonterminal(v, edges);
+	}
+
+	dd::Edge MatrixOperation::getDD(std::unique_ptr<dd::Package>& dd, std::array<short, MAX_QUBITS>&) const {
+		return buildDD(dd, std::vector<short>(qubits.begin(), qubits.end()), false);
+	}
+
+	dd::Edge MatrixOperation::getInverseDD(std::unique_ptr<dd::Package>& dd, std::array<short, MAX_QUBITS>&) const {
+		return buildDD(dd, std::vector<short>(qubits.begin(), qubits.end()), true);
+	}
+
+	dd::Edge MatrixOperation::getDD(std::unique_ptr<dd::Package>& dd, std::array<short, MAX_QUBITS>&, std::map<unsigned short, unsigned short>& permutation) const {
+		std::vector<short> variables{};
+		for (const auto q: qubits) {
+			variables.emplace_back(permutation.at(q));
+		}
+		return buildDD(dd, variables, false);
+	}
+
+	dd::Edge MatrixOperation::getInverseDD(std::unique_ptr<dd::Package>& dd, std::array<short, MAX_QUBITS>&, std::map<unsigned short, unsigned short>& permutation) const {
+		std::vector<short> variables{};
+		for (const auto q: qubits) {
+			variables.emplace_back(permutation.at(q));
+		}
+		return buildDD(dd, variables, true);
+	}
+
+	dd::Edge MatrixOperation::getDD2(std::unique_ptr<dd::Package>& dd, std::array<short, MAX_QUBITS>&, std::map<unsigned short, unsigned short>& permutation, std::map<unsigned short, unsigned short>& varMap) const {
+		std::vector<short> variables{};
+		for (const auto q: qubits) {
+			variables.emplace_back(varMap.at(permutation.at(q)));
+		}
+		return buildDD(dd, variables, false);
+	}
+
+	dd::Edge MatrixOperation::getInverseDD2(std::unique_ptr<dd::Package>& dd, std::array<short, MAX_QUBITS>&, std::map<unsigned short, unsigned short>& permutation, std::map<unsigned short, unsigned short>& varMap) const {
+		std::vector<short> variables{};
+		for (const auto q: qubits) {
+			variables.emplace_back(varMap.at(permutation.at(q)));
+		}
+		return buildDD(dd, variables, true);
+	}
+
+	void MatrixOperation::relabelQubits(const std::vector<unsigned short>& relabeling) {
+		std::vector<unsigned short> relabeled{};
+		for (const auto q: qubits) {
+			relabeled.emplace_back(relabeling.at(q));
+		}
+		auto sorted = relabeled;
+		std::sort(sorted.begin(), sorted.end());
+		if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+			throw QFRException("[MatrixOperation] Relabeling has to be injective");
+		}
+
+		// bit j of an index moves to the position of the j-th qubit's new label
+		std::vector<std::size_t> position{};
+		for (const auto q: relabeled) {
+			position.emplace_back(static_cast<std::size_t>(std::lower_bound(sorted.begin(), sorted.end(), q) - sorted.begin()));
+		}
+		auto permute = [&position](std::size_t index) {
+			std::size_t result = 0;
+			for (std::size_t j = 0; j < position.size(); ++j) {
+				result |= ((index >> j) & 1u) << position[j];
+			}
+			return result;
+		};
+
+		const std::size_t dim = 1u << qubits.size();
+		Matrix permuted(matrix.size());
+		for (std::size_t row = 0; row < dim; ++row) {
+			for (std::size_t col = 0; col < dim; ++col) {
+				permuted[permute(row)*dim + permute(col)] = matrix[row*dim + col];
+			}
+		}
+		matrix = std::move(permuted);
+		qubits = sorted;
+		targets = qubits;
+	}
+
+	void MatrixOperation::checkExportable() const {
+		if (ops.empty()) {
+			throw QFRException("[MatrixOperation] Matrix operation has no gate decomposition and cannot be exported");
+		}
+	}
+
+	std::ostream& MatrixOperation::print(std::ostream& os, const std::map<unsigned short, unsigned short>& permutation) const {
+		os << name;
+		for (const auto q: qubits) {
+			os << " " << q;
+		}
+		for (const auto& op: ops) {
+			os << std::endl << "\t";
+			op->print(os, permutation);
+		}
+		return os;
+	}
+}
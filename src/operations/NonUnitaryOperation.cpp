@@ -111,19 +111,19 @@ namespace qc {
 			case Measure: 
 				if(isWholeQubitRegister(qreg, controls[0].qubit, controls.back().qubit) && 
 				   isWholeQubitRegister(qreg, targets[0],        targets.back())) {
-					of << "measure " << qreg[controls[0].qubit].first << " -> " << creg[targets[0]].first << ";" << std::endl;
+					of << "measure " << qreg[controls[0].qubit].first << " -> " << creg[targets[0]].first << ";" << '\n';
 				} else {
 					for (unsigned int q = 0; q < controls.size(); ++q) {
-						of << "measure " << qreg[controls[q].qubit].second << " -> " << creg[targets[q]].second << ";" << std::endl;
+						of << "measure " << qreg[controls[q].qubit].second << " -> " << creg[targets[q]].second << ";" << '\n';
 					}
 				}
 				break;
 			case Reset: 
 				if(isWholeQubitRegister(qreg, targets[0], targets.back())) {
-					of << "reset " << qreg[targets[0]].first << ";" << std::endl;
+					of << "reset " << qreg[targets[0]].first << ";" << '\n';
 				} else {
 					for (auto target: targets) {
-						of << "reset " << qreg[target].second << ";" << std::endl;
+						of << "reset " << qreg[target].second << ";" << '\n';
 					}
 				}
 				break;
@@ -137,18 +137,18 @@ namespace qc {
 						}
 						of << qreg[targets[q]].second;
 					}
-					of << ";" << std::endl;
+					of << ";" << '\n';
 				}
 				break;
 			case ShowProbabilities: 
-				of << "show_probabilities;" << std::endl;
+				of << "show_probabilities;" << '\n';
 				break;
 			case Barrier: 
 				if(isWholeQubitRegister(qreg, targets[0],        targets.back())) {
-					of << "barrier " << qreg[targets[0]].first << ";" << std::endl;
+					of << "barrier " << qreg[targets[0]].first << ";" << '\n';
 				} else {
 					for (auto target: targets) {
-						of << "barrier " << qreg[target].second << ";" << std::endl;
+						of << "barrier " << qreg[target].second << ";" << '\n';
 					}
 				}
 				break;
@@ -163,7 +163,7 @@ namespace qc {
 			case Measure:
 				if(isWholeQubitRegister(qreg, controls[0].qubit, controls.back().qubit) &&
 				   isWholeQubitRegister(qreg, targets[0],        targets.back())) {
-					of << "qc.measure(" << qreg[controls[0].qubit].first << ", " << creg[targets[0]].first << ")" << std::endl;
+					of << "qc.measure(" << qreg[controls[0].qubit].first << ", " << creg[targets[0]].first << ")" << '\n';
 				} else {
 					of << "qc.measure([";
 					for (auto control : controls) {
@@ -173,18 +173,18 @@ namespace qc {
 					for (unsigned short target : targets) {
 						of << creg[target].second << ", ";
 					}
-					of << "])" << std::endl;
+					of << "])" << '\n';
 				}
 				break;
 			case Reset:
 				if(isWholeQubitRegister(qreg, targets[0], targets.back())) {
-					of << "append(Reset(), " << qreg[targets[0]].first << ", [])" << std::endl;
+					of << "append(Reset(), " << qreg[targets[0]].first << ", [])" << '\n';
 				} else {
 					of << "append(Reset(), [";
 					for (auto target: targets) {
-						of << qreg[target].second << ", " << std::endl;
+						of << qreg[target].second << ", " << '\n';
 					}
-					of << "], [])" << std::endl;
+					of << "], [])" << '\n';
 				}
 				break;
 			case Snapshot:
@@ -193,7 +193,7 @@ namespace qc {
 					for (unsigned short target : targets) {
 						of << qreg[target].second << ", ";
 					}
-					of << "])" << std::endl;
+					of << "])" << '\n';
 				}
 				break;
 			case ShowProbabilities:
@@ -201,13 +201,13 @@ namespace qc {
 				break;
 			case Barrier:
 				if(isWholeQubitRegister(qreg, targets[0],        targets.back())) {
-					of << "qc.barrier(" << qreg[targets[0]].first << ")" << std::endl;
+					of << "qc.barrier(" << qreg[targets[0]].first << ")" << '\n';
 				} else {
 					of << "qc.barrier([";
 					for (auto target: targets) {
 						of  << qreg[target].first << ", ";
 					}
-					of << "])" << std::endl;
+					of << "])" << '\n';
 				}
 				break;
 			default:
@@ -5,6 +5,9 @@
 
 #include "operations/StandardOperation.hpp"
 
+#include <cstdio>
+#include <complex>
+
 namespace qc {
     /***
      * Protected Methods
@@ -248,14 +251,38 @@ namespace qc {
 		return e;
     }
 
+	GateMatrix StandardOperation::getGateMatrix(bool inverse) const {
+		switch (type) {
+			case I:    return Imat;
+			case H:    return Hmat;
+			case X:    return Xmat;
+			case Y:    return Ymat;
+			case Z:    return Zmat;
+			case S:    return inverse? Sdagmat: Smat;
+			case Sdag: return inverse? Smat: Sdagmat;
+			case T:    return inverse? Tdagmat: Tmat;
+			case Tdag: return inverse? Tmat: Tdagmat;
+			case V:    return inverse? Vdagmat: Vmat;
+			case Vdag: return inverse? Vmat: Vdagmat;
+			case U3:   return inverse? U3mat(-parameter[1], -parameter[0], -parameter[2]): U3mat(parameter[0], parameter[1], parameter[2]);
+			case U2:   return inverse? U2mat(-parameter[1]+PI, -parameter[0]-PI): U2mat(parameter[0], parameter[1]);
+			case U1:   return inverse? RZmat(-parameter[0]): RZmat(parameter[0]);
+			case RX:   return inverse? RXmat(-parameter[0]): RXmat(parameter[0]);
+			case RY:   return inverse? RYmat(-parameter[0]): RYmat(parameter[0]);
+			case RZ:   return inverse? RZmat(-parameter[0]): RZmat(parameter[0]);
+			default:
+				std::ostringstream oss{};
+				oss << "DD for gate" << name << " not available!";
+				throw QFRException(oss.str());
+		}
+	}
+
 	dd::Edge StandardOperation::getDD(std::unique_ptr<dd::Package>& dd, std::array<short, MAX_QUBITS>& line, bool inverse, const std::map<unsigned short, unsigned short>& permutation
 	) const {
 		dd::Edge e{ };
 		GateMatrix gm;
 		//TODO add assertions ?
 		switch (type) {
-			case I:	gm = Imat; break;
-			case H: gm = Hmat; break;
 			case X:
 				if (controls.size() > 1) { //Toffoli //TODO > 0 (include CNOT?)
 					e = dd->TTlookup(nqubits, static_cast<unsigned short>(controls.size()), targets[0], line.data());
@@ -267,20 +294,6 @@ namespace qc {
 				}
 				gm = Xmat;
 				break;
-			case Y:    gm = Ymat; break;
-			case Z:    gm = Zmat; break;
-			case S:    gm = inverse? Sdagmat: Smat; break;
-			case Sdag: gm = inverse? Smat: Sdagmat; break;
-			case T:    gm = inverse? Tdagmat: Tmat; break;
-			case Tdag: gm = inverse? Tmat: Tdagmat; break;
-			case V:    gm = inverse? Vdagmat: Vmat; break;
-			case Vdag: gm = inverse? Vmat: Vdagmat; break;
-			case U3:   gm = inverse? U3mat(-parameter[1], -parameter[0], -parameter[2]): U3mat(parameter[0], parameter[1], parameter[2]); break;
-			case U2:   gm = inverse? U2mat(-parameter[1]+PI, -parameter[0]-PI): U2mat(parameter[0], parameter[1]); break;
-			case U1:   gm = inverse? RZmat(-parameter[0]): RZmat(parameter[0]); break;
-			case RX:   gm = inverse? RXmat(-parameter[0]): RXmat(parameter[0]); break;
-			case RY:   gm = inverse? RYmat(-parameter[0]): RYmat(parameter[0]); break;
-			case RZ:   gm = inverse? RZmat(-parameter[0]): RZmat(parameter[0]); break;
 			case SWAP:
 				return getSWAPDD(dd, line, permutation);
 			case iSWAP:
@@ -302,9 +315,8 @@ namespace qc {
 					return getPdagDD(dd, line, permutation);
 				}
 			default:
-				std::ostringstream oss{};
-				oss << "DD for gate" << name << " not available!";
-				throw QFRException(oss.str());
+				gm = getGateMatrix(inverse);
+				break;
 		}
 		if (multiTarget && !controlled) {
 			throw QFRException("Multi target gates not implemented yet!");
@@ -410,8 +422,6 @@ namespace qc {
 		GateMatrix gm;
 		//TODO add assertions ?
 		switch (type) {
-			case I:	gm = Imat; break;
-			case H: gm = Hmat; break;
 			case X:
 				if (controls.size() > 1) { //Toffoli //TODO > 0 (include CNOT?)
 					e = dd->TTlookup(nqubits, static_cast<unsigned short>(controls.size()), targets[0], line.data());
@@ -423,20 +433,6 @@ namespace qc {
 				}
 				gm = Xmat;
 				break;
-			case Y:    gm = Ymat; break;
-			case Z:    gm = Zmat; break;
-			case S:    gm = inverse? Sdagmat: Smat; break;
-			case Sdag: gm = inverse? Smat: Sdagmat; break;
-			case T:    gm = inverse? Tdagmat: Tmat; break;
-			case Tdag: gm = inverse? Tmat: Tdagmat; break;
-			case V:    gm = inverse? Vdagmat: Vmat; break;
-			case Vdag: gm = inverse? Vmat: Vdagmat; break;
-			case U3:   gm = inverse? U3mat(-parameter[1], -parameter[0], -parameter[2]): U3mat(parameter[0], parameter[1], parameter[2]); break;
-			case U2:   gm = inverse? U2mat(-parameter[1]+PI, -parameter[0]-PI): U2mat(parameter[0], parameter[1]); break;
-			case U1:   gm = inverse? RZmat(-parameter[0]): RZmat(parameter[0]); break;
-			case RX:   gm = inverse? RXmat(-parameter[0]): RXmat(parameter[0]); break;
-			case RY:   gm = inverse? RYmat(-parameter[0]): RYmat(parameter[0]); break;
-			case RZ:   gm = inverse? RZmat(-parameter[0]): RZmat(parameter[0]); break;
 			case SWAP:
 				return getSWAPDD2(dd, line, permutation, varMap);
 			case iSWAP:
@@ -458,8 +454,8 @@ namespace qc {
 					return getPdagDD2(dd, line, permutation, varMap);
 				}
 			default:
-				std::cerr << "DD for gate" << name << " not available!" << std::endl;
-				exit(1);
+				gm = getGateMatrix(inverse);
+				break;
 		}
 		if (multiTarget && !controlled) {
 			std::cerr << "Multi target gates not implemented yet!" << std::endl;
@@ -518,6 +514,33 @@ namespace qc {
 			controlled = true;
 	}
 
+	StandardOperation::StandardOperation(unsigned short nq, unsigned short target, const GateMatrix& matrix) {
+		// decompose matrix = e^(i*alpha) * U3(theta, phi, lambda)
+		const std::complex<fp> m00(matrix[0].r, matrix[0].i);
+		const std::complex<fp> m01(matrix[1].r, matrix[1].i);
+		const std::complex<fp> m10(matrix[2].r, matrix[2].i);
+		const std::complex<fp> m11(matrix[3].r, matrix[3].i);
+
+		fp theta = 2 * std::atan2(std::abs(m10), std::abs(m00));
+		fp phi = 0;
+		fp lambda = 0;
+		if (std::abs(m10) < PARAMETER_TOLERANCE) {
+			// diagonal matrix
+			lambda = std::arg(m11) - std::arg(m00);
+		} else if (std::abs(m00) < PARAMETER_TOLERANCE) {
+			// anti-diagonal matrix
+			lambda = std::arg(-m01) - std::arg(m10);
+		} else {
+			const auto alpha = std::arg(m00);
+			phi = std::arg(m10) - alpha;
+			lambda = std::arg(-m01) - alpha;
+		}
+
+		type = U3;
+		setup(nq, normalizeAngle(lambda), normalizeAngle(phi), theta);
+		targets.push_back(target);
+	}
+
 	// MCT Constructor
 	StandardOperation::StandardOperation(unsigned short nq, const std::vector<Control>& controls, unsigned short target) 
 		: StandardOperation(nq, controls, target, X) {
@@ -532,151 +555,158 @@ namespace qc {
      * Public Methods
     ***/
 	void StandardOperation::dumpOpenQASM(std::ostream& of, const regnames_t& qreg, const regnames_t& creg) const {
-		std::ostringstream op;
-		op << std::setprecision(std::numeric_limits<fp>::digits10);
+		// parameters are formatted exactly like a stream with precision digits10 would do,
+		// but without the overhead of constructing a stream for every operation
+		auto param = [](fp value) {
+			char buffer[32];
+			std::snprintf(buffer, sizeof(buffer), "%.*g", std::numeric_limits<fp>::digits10, static_cast<double>(value));
+			return std::string(buffer);
+		};
+		std::string op;
+		op.reserve(32);
 		if((controls.size() > 1 && type != X) || controls.size() > 2) {
 			std::cout << "[WARNING] Multiple controlled gates are not natively suppported by OpenQASM. "
 			<< "However, this library can parse .qasm files with multiple controlled gates (e.g., cccx) correctly. "
 			<< "Thus, while not valid vanilla OpenQASM, the dumped file will work with this library. " << std::endl;
 		}
 
-		op << std::string(controls.size(), 'c');
+		op.append(controls.size(), 'c');
 
 		switch (type) {
 			case I: 
-               	op << "id";
+               	op += "id";
 				break;
 			case H:
-				op << "h";
+				op += "h";
 				break;
 			case X:
-				op << "x";
+				op += "x";
 				break;
 			case Y:
-				op << "y";
+				op += "y";
 				break;
 			case Z:
-				op << "z";
+				op += "z";
 				break;
 			case S:
 				if(!controls.empty()) {
-					op << "u1(pi/2)";
+					op += "u1(pi/2)";
 				} else {
-					op << "s";
+					op += "s";
 				}
 				break;
 			case Sdag:
 				if(!controls.empty()) {
-					op << "u1(-pi/2)";
+					op += "u1(-pi/2)";
 				} else {
-					op << "sdg";
+					op += "sdg";
 				}
 				break;
 			case T:
 				if(!controls.empty()) {
-					op << "u1(pi/4)";
+					op += "u1(pi/4)";
 				} else {
-					op << "t";
+					op += "t";
 				}
 				break;
 			case Tdag:
 				if(!controls.empty()) {
-					op << "u1(-pi/4)";
+					op += "u1(-pi/4)";
 				} else {
-					op << "tdg";
+					op += "tdg";
 				}
 				break;
 			case V:
-				op << "u3(pi/2, -pi/2, pi/2)";
+				op += "u3(pi/2, -pi/2, pi/2)";
 				break;
 			case Vdag:
-				op << "u3(pi/2, pi/2, -pi/2)";
+				op += "u3(pi/2, pi/2, -pi/2)";
 				break;
 			case U3: 
-				op << "u3(" << parameter[2] << "," << parameter[1] << "," << parameter[0] << ")";
+				op += "u3(" + param(parameter[2]) + "," + param(parameter[1]) + "," + param(parameter[0]) + ")";
 				break;
 			case U2:
-				op << "u2(" << parameter[1] << "," << parameter[0] << ")";
+				op += "u2(" + param(parameter[1]) + "," + param(parameter[0]) + ")";
 				break;
 			case U1: 
-				op << "u1(" << parameter[0] << ")";
+				op += "u1(" + param(parameter[0]) + ")";
 				break;
 			case RX:
-				op << "rx(" << parameter[0] << ")";
+				op += "rx(" + param(parameter[0]) + ")";
 				break;
 			case RY:
-				op << "ry(" << parameter[0] << ")";
+				op += "ry(" + param(parameter[0]) + ")";
 				break;
 			case RZ: 
-				op << "rz(" << parameter[0] << ")";
+				op += "rz(" + param(parameter[0]) + ")";
 				break;
 			case SWAP:
 				for (const auto& c: controls) {
 					if (c.type == Control::neg)
-						of << "x " << qreg[c.qubit].second << ";" << std::endl;
+						of << "x " << qreg[c.qubit].second << ";" << '\n';
 				}
 
-				of << op.str() <<  "swap";
+				of << op <<  "swap";
 				for (const auto& c: controls)
 					of << " " << qreg[c.qubit].second << ",";
-				of << " " << qreg[targets[0]].second << ", " << qreg[targets[1]].second << ";" << std::endl;
+				of << " " << qreg[targets[0]].second << ", " << qreg[targets[1]].second << ";" << '\n';
 
 				for (const auto& c: controls) {
 					if (c.type == Control::neg)
-						of << "x " << qreg[c.qubit].second << ";" << std::endl;
+						of << "x " << qreg[c.qubit].second << ";" << '\n';
 				}
 				return;
 			case iSWAP:
 				for (const auto& c: controls) {
 					if (c.type == Control::neg)
-						of << "x " << qreg[c.qubit].second << ";" << std::endl;
+						of << "x " << qreg[c.qubit].second << ";" << '\n';
 				}
-				of << op.str() << "swap";
+				of << op << "swap";
 				for (const auto& c: controls)
 					of << " " << qreg[c.qubit].second << ",";
-				of << " " << qreg[targets[0]].second << ", " << qreg[targets[1]].second << ";" << std::endl;
+				of << " " << qreg[targets[0]].second << ", " << qreg[targets[1]].second << ";" << '\n';
 
-				of << op.str() << "s";
+				of << op << "s";
 				for (const auto& c: controls)
 					of << " " << qreg[c.qubit].second << ",";
-				of << " " << qreg[targets[0]].second << ";"  << std::endl;
+				of << " " << qreg[targets[0]].second << ";"  << '\n';
 
-				of << op.str() << "s";
+				of << op << "s";
 				for (const auto& c: controls)
 					of << " " << qreg[c.qubit].second << ",";
-				of << " " << qreg[targets[1]].second << ";"  << std::endl;
+				of << " " << qreg[targets[1]].second << ";"  << '\n';
 
-                of << op.str() << "cz";
+                of << op << "cz";
 				for (const auto& c: controls)
 					of << " " << qreg[c.qubit].second << ",";
-                of << qreg[targets[0]].second << ", " << qreg[targets[1]].second << ";" << std::endl;
+                of << qreg[targets[0]].second << ", " << qreg[targets[1]].second << ";" << '\n';
 
 				for (const auto& c: controls) {
 					if (c.type == Control::neg)
-						of << "x " << qreg[c.qubit].second << ";" << std::endl;
+						of << "x " << qreg[c.qubit].second << ";" << '\n';
 				}
                 return;
 			case P: 
-                of << op.str() << "cx";
+                of << op << "cx";
 				for (const auto& c: controls)
 					of << " " << qreg[c.qubit].second << ",";
-                of << qreg[targets[1]].second << ", " << qreg[targets[0]].second << ";" << std::endl;
+                of << qreg[targets[1]].second << ", " << qreg[targets[0]].second << ";" << '\n';
 
-                of << op.str() << "x";
+                of << op << "x";
 				for (const auto& c: controls)
 					of << " " << qreg[c.qubit].second << ",";
-                of << qreg[targets[1]].second << ";" << std::endl;
+                of << qreg[targets[1]].second << ";" << '\n';
 				return;
 			case Pdag:
-				of << op.str() << "x";
+				of << op << "x";
 				for (const auto& c: controls)
 					of << " " << qreg[c.qubit].second << ",";
-				of << qreg[targets[1]].second << ";" << std::endl;
+				of << qreg[targets[1]].second << ";" << '\n';
 
-				of << op.str() << "cx";
+				of << op << "cx";
 				for (const auto& c: controls)
 					of << " " << qreg[c.qubit].second << ",";
-				of << qreg[targets[1]].second << ", " << qreg[targets[0]].second << ";" << std::endl;
+				of << qreg[targets[1]].second << ", " << qreg[targets[0]].second << ";" << '\n';
 				return;
 			default: 
                 std::cerr << "gate type (index) " << (int) type << " could not be converted to OpenQASM" << std::endl;
@@ -684,39 +714,46 @@ namespace qc {
 
 		for (const auto& c: controls) {
 			if (c.type == Control::neg)
-				of << "x " << qreg[c.qubit].second << ";" << std::endl;
+				of << "x " << qreg[c.qubit].second << ";" << '\n';
 		}
-		of << op.str();
+		of << op;
 		for (const auto& c: controls) {
 			of << " " << qreg[c.qubit].second << ",";
 		}
         for(auto target: targets) {
-			of << " " << qreg[target].second << ";" << std::endl;
+			of << " " << qreg[target].second << ";" << '\n';
 		}
 		for (const auto& c: controls) {
 			if (c.type == Control::neg)
-				of << "x " << qreg[c.qubit].second << ";" << std::endl;
+				of << "x " << qreg[c.qubit].second << ";" << '\n';
 		}
 	}
 
 	void StandardOperation::dumpReal([[maybe_unused]] std::ostream& of) const {}
 
 	void StandardOperation::dumpQiskit(std::ostream& of, const regnames_t& qreg,[[maybe_unused]] const regnames_t& creg, const char* anc_reg_name) const {
-		std::ostringstream op;
+		// parameters are formatted like a stream with the default precision would do
+		auto param = [](fp value) {
+			char buffer[32];
+			std::snprintf(buffer, sizeof(buffer), "%g", static_cast<double>(value));
+			return std::string(buffer);
+		};
+		std::string op;
+		op.reserve(32);
 		if (targets.size() > 2 || (targets.size() > 1 && type != SWAP && type != iSWAP && type != P && type != Pdag)) {
 			std::cerr << "Multiple targets are not supported in general at the moment" << std::endl;
 		}
 		switch (type) {
 			case I:
-				op << "qc.iden(";
+				op += "qc.iden(";
 				break;
 			case H:
 				switch(controls.size()) {
 					case 0:
-						op << "qc.h(";
+						op += "qc.h(";
 						break;
 					case 1:
-						op << "qc.ch(" << qreg[controls[0].qubit].second << ", ";
+						op += "qc.ch(" + qreg[controls[0].qubit].second + ", ";
 						break;
 					default:
 						std::cerr << "Multi-controlled H gate currently not supported" << std::endl;
@@ -725,31 +762,31 @@ namespace qc {
 			case X:
 				switch(controls.size()) {
 					case 0:
-						op << "qc.x(";
+						op += "qc.x(";
 						break;
 					case 1:
-						op << "qc.cx(" << qreg[controls[0].qubit].second << ", ";
+						op += "qc.cx(" + qreg[controls[0].qubit].second + ", ";
 						break;
 					case 2:
-						op << "qc.ccx(" << qreg[controls[0].qubit].second << ", " << qreg[controls[1].qubit].second << ", ";
+						op += "qc.ccx(" + qreg[controls[0].qubit].second + ", " + qreg[controls[1].qubit].second + ", ";
 						break;
 					default:
-						op << "qc.mct([";
+						op += "qc.mct([";
 						for (const auto& control:controls) {
-							op << qreg[control.qubit].second << ", ";
+							op += qreg[control.qubit].second + ", ";
 						}
-						op << "], " << qreg[targets[0]].second << ", " << anc_reg_name << ", mode='basic')" << std::endl;
-						of << op.str();
+						op += "], " + qreg[targets[0]].second + ", " + anc_reg_name + ", mode='basic')" + '\n';
+						of << op;
 						return;
 				}
 				break;
 			case Y:
 				switch(controls.size()) {
 					case 0:
-						op << "qc.y(";
+						op += "qc.y(";
 						break;
 					case 1:
-						op << "qc.cy(" << qreg[controls[0].qubit].second << ", ";
+						op += "qc.cy(" + qreg[controls[0].qubit].second + ", ";
 						break;
 					default:
 						std::cerr << "Multi-controlled Y gate currently not supported" << std::endl;
@@ -757,66 +794,66 @@ namespace qc {
 				break;
 			case Z:
 				if (!controls.empty()) {
-					op << "qc.mcu1(pi, [";
+					op += "qc.mcu1(pi, [";
 					for (const auto& control:controls) {
-						op << qreg[control.qubit].second << ", ";
+						op += qreg[control.qubit].second + ", ";
 					}
-					op << "], ";
+					op += "], ";
 				} else {
-					op << "qc.z(";
+					op += "qc.z(";
 				}
 				break;
 			case S:
 				if (!controls.empty()) {
-					op << "qc.mcu1(pi/2, [";
+					op += "qc.mcu1(pi/2, [";
 					for (const auto& control:controls) {
-						op << qreg[control.qubit].second << ", ";
+						op += qreg[control.qubit].second + ", ";
 					}
-					op << "], ";
+					op += "], ";
 				} else {
-					op << "qc.s(";
+					op += "qc.s(";
 				}
 				break;
 			case Sdag:
 				if (!controls.empty()) {
-					op << "qc.mcu1(-pi/2, [";
+					op += "qc.mcu1(-pi/2, [";
 					for (const auto& control:controls) {
-						op << qreg[control.qubit].second << ", ";
+						op += qreg[control.qubit].second + ", ";
 					}
-					op << "], ";
+					op += "], ";
 				} else {
-					op << "qc.sdg(";
+					op += "qc.sdg(";
 				}
 				break;
 			case T:
 				if (!controls.empty()) {
-					op << "qc.mcu1(pi/4, [";
+					op += "qc.mcu1(pi/4, [";
 					for (const auto& control:controls) {
-						op << qreg[control.qubit].second << ", ";
+						op += qreg[control.qubit].second + ", ";
 					}
-					op << "], ";
+					op += "], ";
 				} else {
-					op << "qc.t(";
+					op += "qc.t(";
 				}
 				break;
 			case Tdag:
 				if (!controls.empty()) {
-					op << "qc.mcu1(-pi/4, [";
+					op += "qc.mcu1(-pi/4, [";
 					for (const auto& control:controls) {
-						op << qreg[control.qubit].second << ", ";
+						op += qreg[control.qubit].second + ", ";
 					}
-					op << "], ";
+					op += "], ";
 				} else {
-					op << "qc.tdg(";
+					op += "qc.tdg(";
 				}
 				break;
 			case V:
 				switch(controls.size()) {
 					case 0:
-						op << "qc.u3(pi/2, -pi/2, pi/2, ";
+						op += "qc.u3(pi/2, -pi/2, pi/2, ";
 						break;
 					case 1:
-						op << "qc.cu3(pi/2, -pi/2, pi/2, " << qreg[controls[0].qubit].second << ", ";
+						op += "qc.cu3(pi/2, -pi/2, pi/2, " + qreg[controls[0].qubit].second + ", ";
 						break;
 					default:
 						std::cerr << "Multi-controlled V gate currently not supported" << std::endl;
@@ -825,10 +862,10 @@ namespace qc {
 			case Vdag:
 				switch(controls.size()) {
 					case 0:
-						op << "qc.u3(pi/2, pi/2, -pi/2, ";
+						op += "qc.u3(pi/2, pi/2, -pi/2, ";
 						break;
 					case 1:
-						op << "qc.cu3(pi/2, pi/2, -pi/2, " << qreg[controls[0].qubit].second << ", ";
+						op += "qc.cu3(pi/2, pi/2, -pi/2, " + qreg[controls[0].qubit].second + ", ";
 						break;
 					default:
 						std::cerr << "Multi-controlled Vdag gate currently not supported" << std::endl;
@@ -837,10 +874,10 @@ namespace qc {
 			case U3:
 				switch(controls.size()) {
 					case 0:
-						op << "qc.u3(" << parameter[2] << ", " << parameter[1] << ", " << parameter[0] << ", ";
+						op += "qc.u3(" + param(parameter[2]) + ", " + param(parameter[1]) + ", " + param(parameter[0]) + ", ";
 						break;
 					case 1:
-						op << "qc.cu3(" << parameter[2] << ", " << parameter[1] << ", " << parameter[0] << ", " << qreg[controls[0].qubit].second << ", ";
+						op += "qc.cu3(" + param(parameter[2]) + ", " + param(parameter[1]) + ", " + param(parameter[0]) + ", " + qreg[controls[0].qubit].second + ", ";
 						break;
 					default:
 						std::cerr << "Multi-controlled U3 gate currently not supported" << std::endl;
@@ -849,10 +886,10 @@ namespace qc {
 			case U2:
 				switch(controls.size()) {
 					case 0:
-						op << "qc.u3(pi/2, " << parameter[1] << ", " << parameter[0] << ", ";
+						op += "qc.u3(pi/2, " + param(parameter[1]) + ", " + param(parameter[0]) + ", ";
 						break;
 					case 1:
-						op << "qc.cu3(pi/2, " << parameter[1] << ", " << parameter[0] << ", " << qreg[controls[0].qubit].second << ", ";
+						op += "qc.cu3(pi/2, " + param(parameter[1]) + ", " + param(parameter[0]) + ", " + qreg[controls[0].qubit].second + ", ";
 						break;
 					default:
 						std::cerr << "Multi-controlled U2 gate currently not supported" << std::endl;
@@ -860,97 +897,97 @@ namespace qc {
 				break;
 			case U1:
 				if (!controls.empty()) {
-					op << "qc.mcu1(" << parameter[0] << ", [";
+					op += "qc.mcu1(" + param(parameter[0]) + ", [";
 					for (const auto& control:controls) {
-						op << qreg[control.qubit].second << ", ";
+						op += qreg[control.qubit].second + ", ";
 					}
-					op << "], ";
+					op += "], ";
 				} else {
-					op << "qc.u1(" << parameter[0] << ", ";
+					op += "qc.u1(" + param(parameter[0]) + ", ";
 				}
 				break;
 			case RX:
 				if (!controls.empty()) {
-					op << "qc.mcrx(" << parameter[0] << ", [";
+					op += "qc.mcrx(" + param(parameter[0]) + ", [";
 					for (const auto& control:controls) {
-						op << qreg[control.qubit].second << ", ";
+						op += qreg[control.qubit].second + ", ";
 					}
-					op << "], ";
+					op += "], ";
 				} else {
-					op << "qc.rx(" << parameter[0] << ", ";
+					op += "qc.rx(" + param(parameter[0]) + ", ";
 				}
 				break;
 			case RY:
 				if (!controls.empty()) {
-					op << "qc.mcry(" << parameter[0] << ", [";
+					op += "qc.mcry(" + param(parameter[0]) + ", [";
 					for (const auto& control:controls) {
-						op << qreg[control.qubit].second << ", ";
+						op += qreg[control.qubit].second + ", ";
 					}
-					op << "], ";
+					op += "], ";
 				} else {
-					op << "qc.ry(" << parameter[0] << ", ";
+					op += "qc.ry(" + param(parameter[0]) + ", ";
 				}
 				break;
 			case RZ:
 				if (!controls.empty()) {
-					op << "qc.mcrz(" << parameter[0] << ", [";
+					op += "qc.mcrz(" + param(parameter[0]) + ", [";
 					for (const auto& control:controls) {
-						op << qreg[control.qubit].second << ", ";
+						op += qreg[control.qubit].second + ", ";
 					}
-					op << "], ";
+					op += "], ";
 				} else {
-					op << "qc.rz(" << parameter[0] << ", ";
+					op += "qc.rz(" + param(parameter[0]) + ", ";
 				}
 				break;
 			case SWAP:
 				switch(controls.size()) {
 					case 0:
-						of << "qc.swap(" << qreg[targets[0]].second << ", " << qreg[targets[1]].second << ")" << std::endl;
+						of << "qc.swap(" << qreg[targets[0]].second << ", " << qreg[targets[1]].second << ")" << '\n';
 						break;
 					case 1:
-						of << "qc.cswap(" << qreg[controls[0].qubit].second << ", " << qreg[targets[0]].second << ", " << qreg[targets[1]].second << ")" << std::endl;
+						of << "qc.cswap(" << qreg[controls[0].qubit].second << ", " << qreg[targets[0]].second << ", " << qreg[targets[1]].second << ")" << '\n';
 						break;
 					default:
-						of << "qc.cx(" << qreg[targets[1]].second << ", " << qreg[targets[0]].second << ")" << std::endl;
+						of << "qc.cx(" << qreg[targets[1]].second << ", " << qreg[targets[0]].second << ")" << '\n';
 						of << "qc.mct([";
 						for (const auto& control:controls) {
 							of << qreg[control.qubit].second << ", ";
 						}
-						of << qreg[targets[0]].second << "], " << qreg[targets[1]].second << ", " << anc_reg_name << ", mode='basic')" << std::endl;
-						of << "qc.cx(" << qreg[targets[1]].second << ", " << qreg[targets[0]].second << ")" << std::endl;
+						of << qreg[targets[0]].second << "], " << qreg[targets[1]].second << ", " << anc_reg_name << ", mode='basic')" << '\n';
+						of << "qc.cx(" << qreg[targets[1]].second << ", " << qreg[targets[0]].second << ")" << '\n';
 						break;
 				}
 				return;
 			case iSWAP:
 				switch(controls.size()) {
 					case 0:
-						of << "qc.swap(" << qreg[targets[0]].second << ", " << qreg[targets[1]].second << ")" << std::endl;
-						of << "qc.s(" << qreg[targets[0]].second << ")" << std::endl;
-						of << "qc.s(" << qreg[targets[1]].second << ")" << std::endl;
-						of << "qc.cz(" << qreg[targets[0]].second << ", " << qreg[targets[1]].second << ")" << std::endl;
+						of << "qc.swap(" << qreg[targets[0]].second << ", " << qreg[targets[1]].second << ")" << '\n';
+						of << "qc.s(" << qreg[targets[0]].second << ")" << '\n';
+						of << "qc.s(" << qreg[targets[1]].second << ")" << '\n';
+						of << "qc.cz(" << qreg[targets[0]].second << ", " << qreg[targets[1]].second << ")" << '\n';
 						break;
 					case 1:
-						of << "qc.cswap(" << qreg[controls[0].qubit].second << ", " << qreg[targets[0]].second << ", " << qreg[targets[1]].second << ")" << std::endl;
-						of << "qc.cu1(pi/2, " << qreg[controls[0].qubit].second << ", " << qreg[targets[0]].second << ")" << std::endl;
-						of << "qc.cu1(pi/2, " << qreg[controls[0].qubit].second << ", " << qreg[targets[1]].second << ")" << std::endl;
-						of << "qc.mcu1(pi, [" << qreg[controls[0].qubit].second << ", " << qreg[targets[0]].second << "], " << qreg[targets[1]].second << ")" << std::endl;
+						of << "qc.cswap(" << qreg[controls[0].qubit].second << ", " << qreg[targets[0]].second << ", " << qreg[targets[1]].second << ")" << '\n';
+						of << "qc.cu1(pi/2, " << qreg[controls[0].qubit].second << ", " << qreg[targets[0]].second << ")" << '\n';
+						of << "qc.cu1(pi/2, " << qreg[controls[0].qubit].second << ", " << qreg[targets[1]].second << ")" << '\n';
+						of << "qc.mcu1(pi, [" << qreg[controls[0].qubit].second << ", " << qreg[targets[0]].second << "], " << qreg[targets[1]].second << ")" << '\n';
 						break;
 					default:
 						std::cerr << "Multi-controlled iSWAP gate currently not supported" << std::endl;
 				}
 				return;
 			case P:
-				of << "qc.ccx(" << qreg[controls[0].qubit].second << ", " << qreg[targets[1]].second << ", " << qreg[targets[0]].second << ")" << std::endl;
-				of << "qc.cx(" << qreg[controls[0].qubit].second << ", " << qreg[targets[1]].second << ")" << std::endl;
+				of << "qc.ccx(" << qreg[controls[0].qubit].second << ", " << qreg[targets[1]].second << ", " << qreg[targets[0]].second << ")" << '\n';
+				of << "qc.cx(" << qreg[controls[0].qubit].second << ", " << qreg[targets[1]].second << ")" << '\n';
 				return;
 			case Pdag:
-				of << "qc.cx(" << qreg[controls[0].qubit].second << ", " << qreg[targets[1]].second << ")" << std::endl;
-				of << "qc.ccx(" << qreg[controls[0].qubit].second << ", " << qreg[targets[1]].second << ", " << qreg[targets[0]].second << ")" << std::endl;
+				of << "qc.cx(" << qreg[controls[0].qubit].second << ", " << qreg[targets[1]].second << ")" << '\n';
+				of << "qc.ccx(" << qreg[controls[0].qubit].second << ", " << qreg[targets[1]].second << ", " << qreg[targets[0]].second << ")" << '\n';
 				return;
 			default:
 				std::cerr << "gate type (index) " << (int) type << " could not be converted to qiskit" << std::endl;
 		}
-		of << op.str() << qreg[targets[0]].second << ")" << std::endl;
+		of << op << qreg[targets[0]].second << ")" << '\n';
 	}
 
 
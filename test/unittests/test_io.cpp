@@ -192,3 +192,143 @@ TEST_F(IO, tfc_input) {
 	qc->import("./circuits/test.tfc");
 	std::cout << *qc << std::endl;
 }
+
+TEST_F(IO, parallel_import) {
+	std::stringstream ss{};
+	ss << "OPENQASM 2.0;\ninclude \"qelib1.inc\";\nqreg q[3];\ncreg c[3];\n";
+	ss << "gate mygate a, b { cx a, b; h b; }\n";
+	for (int i = 0; i < 50; ++i) {
+		ss << "h q[" << i%3 << "];\n";
+		ss << "mygate q[" << i%3 << "], q[" << (i+1)%3 << "]; // comment;\n";
+		ss << "u3(0.1,0.2," << i << ") q[" << (i+2)%3 << "];\n";
+	}
+	ss << "barrier q;\nmeasure q -> c;\n";
+	std::string circuit = ss.str();
+
+	qc->import(std::stringstream{circuit}, qc::OpenQASM);
+	std::stringstream sequential{};
+	qc->dumpOpenQASM(sequential);
+
+	ASSERT_NO_THROW(qc->import(std::stringstream{circuit}, qc::OpenQASM, 4));
+	std::stringstream parallel{};
+	qc->dumpOpenQASM(parallel);
+	EXPECT_EQ(qc->getNops(), 152);
+	EXPECT_EQ(sequential.str(), parallel.str());
+}
+
+TEST_F(IO, parallel_import_fallback) {
+	std::string circuit_qasm = "OPENQASM 2.0;\ninclude \"qelib1.inc\";\nqreg q[2];\ncreg c[2];\nh q[0];\nmeasure q[0] -> c[0];\nif(c==1) x q[1];\n";
+	ASSERT_NO_THROW(qc->import(std::stringstream{circuit_qasm}, qc::OpenQASM, 4));
+	ASSERT_EQ(qc->getNops(), 3);
+	EXPECT_TRUE((*qc->rbegin())->isClassicControlledOperation());
+
+	std::string invalid_qasm = "OPENQASM 2.0;\ninclude \"qelib1.inc\";\nqreg q[2];\nh q[0];\ncx q[0];\nh q[1];\n";
+	EXPECT_THROW(qc->import(std::stringstream{invalid_qasm}, qc::OpenQASM, 4), qasm::QASMParserException);
+}
+
+TEST_F(IO, binary_roundtrip) {
+	std::string circuit_qasm = "// i 1 0 2\n// o 2 1 0\nOPENQASM 2.0;\ninclude \"qelib1.inc\";\nqreg q[3];\ncreg c[3];\n"
+	                           "u3(0.1,0.2,0.3) q[0];\ncx q[0],q[1];\nccx q[0],q[1],q[2];\nswap q[0],q[2];\nrz(0.25) q[1];\n"
+	                           "barrier q;\nsnapshot(2) q[0],q[1];\nreset q[2];\nmeasure q -> c;\n";
+	qc->import(std::stringstream{circuit_qasm}, qc::OpenQASM);
+	qc->emplace_back<qc::StandardOperation>(qc->getNqubits(), qc::Control(1, qc::Control::neg), 0, qc::X);
+	auto compound = std::make_unique<qc::CompoundOperation>(qc->getNqubits());
+	compound->emplace_back<qc::StandardOperation>(qc->getNqubits(), 0, qc::H);
+	compound->emplace_back<qc::StandardOperation>(qc->getNqubits(), 1, qc::RX, 0.5);
+	qc->insert(qc->end(), std::move(compound));
+	std::unique_ptr<qc::Operation> op = std::make_unique<qc::StandardOperation>(qc->getNqubits(), 2, qc::X);
+	std::pair<unsigned short, unsigned short> creg{0, 3};
+	qc->emplace_back<qc::ClassicControlledOperation>(op, creg, 5u);
+	qc->setLogicalQubitAncillary(2);
+	qc->setLogicalQubitGarbage(1);
+
+	std::stringstream expected{};
+	qc->print(expected);
+
+	ASSERT_NO_THROW(qc->dump("tmp.qfr"));
+	auto imported = qc::QuantumComputation("tmp.qfr");
+	std::stringstream actual{};
+	imported.print(actual);
+	EXPECT_EQ(expected.str(), actual.str());
+	EXPECT_EQ(imported.getNops(), qc->getNops());
+	EXPECT_EQ(imported.initialLayout, qc->initialLayout);
+	EXPECT_EQ(imported.outputPermutation, qc->outputPermutation);
+	EXPECT_EQ(imported.ancillary, qc->ancillary);
+	EXPECT_EQ(imported.garbage, qc->garbage);
+	EXPECT_EQ(imported.getQregs(), qc->getQregs());
+	EXPECT_EQ(imported.getCregs(), qc->getCregs());
+
+	auto cc = dynamic_cast<qc::ClassicControlledOperation*>(imported.rbegin()->get());
+	ASSERT_NE(cc, nullptr);
+	EXPECT_EQ(cc->getExpectedValue(), 5u);
+	EXPECT_EQ(cc->getControlRegister().second, 3);
+
+	std::stringstream ss{};
+	qc->dump(ss, qc::Binary);
+	qc::QuantumComputation fromStream{};
+	ASSERT_NO_THROW(fromStream.import(ss, qc::Binary));
+	EXPECT_EQ(fromStream.getNops(), qc->getNops());
+}
+
+TEST_F(IO, binary_invalid) {
+	std::stringstream ss{"QFRX"};
+	EXPECT_THROW(qc->import(ss, qc::Binary), qc::QFRException);
+
+	std::stringstream truncated{};
+	qc->addQubitRegister(2);
+	qc->emplace_back<qc::StandardOperation>(2, 0, qc::H);
+	qc->dump(truncated, qc::Binary);
+	std::string content = truncated.str();
+	std::stringstream ss2{content.substr(0, content.size()-3)};
+	EXPECT_THROW(qc->import(ss2, qc::Binary), qc::QFRException);
+}
+
+TEST_F(IO, parallel_dump) {
+	qc->addQubitRegister(3);
+	qc->addClassicalRegister(3);
+	for (int i = 0; i < 5000; ++i) {
+		qc->emplace_back<qc::StandardOperation>(3, i%3, qc::RZ, 0.1*i);
+		qc->emplace_back<qc::StandardOperation>(3, qc::Control(i%3), (i+1)%3, qc::X);
+		qc->emplace_back<qc::StandardOperation>(3, (i+2)%3, qc::U3, 0.25, -1./3, 0.001*(i%100));
+	}
+	qc->emplace_back<qc::NonUnitaryOperation>(3, std::vector<unsigned short>{0, 1, 2}, std::vector<unsigned short>{0, 1, 2});
+
+	std::stringstream sequential{};
+	qc->dumpOpenQASM(sequential);
+	std::stringstream parallel{};
+	qc->dumpOpenQASM(parallel, 4);
+	EXPECT_EQ(sequential.str(), parallel.str());
+
+	ASSERT_NO_THROW(qc->dump("tmp.qasm", qc::OpenQASM, 4));
+	std::ifstream ifs("tmp.qasm");
+	std::string fromFile((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+	EXPECT_EQ(sequential.str(), fromFile);
+
+	qc::QuantumComputation reimported("tmp.qasm");
+	EXPECT_EQ(reimported.getNops(), qc->getNops());
+}
+
+TEST_F(IO, parallel_dump_qiskit) {
+	qc->addQubitRegister(3);
+	qc->addClassicalRegister(3);
+	for (int i = 0; i < 5000; ++i) {
+		qc->emplace_back<qc::StandardOperation>(3, i%3, qc::RZ, 0.1*i);
+		qc->emplace_back<qc::StandardOperation>(3, qc::Control(i%3), (i+1)%3, qc::X);
+		qc->emplace_back<qc::StandardOperation>(3, (i+2)%3, qc::U3, 0.25, -1./3, 0.001*(i%100));
+	}
+
+	std::stringstream sequential{};
+	qc->dumpQiskit(sequential);
+	std::stringstream parallel{};
+	qc->dumpQiskit(parallel, 4);
+	EXPECT_EQ(sequential.str(), parallel.str());
+	EXPECT_NE(sequential.str().find("qc.u3(0.099, -0.333333, 0.25, q[1])"), std::string::npos);
+
+	std::stringstream viaDump{};
+	qc->dump(viaDump, qc::Qiskit);
+	EXPECT_EQ(sequential.str(), viaDump.str());
+
+	// formats without a parallel path do not silently ignore the number of threads
+	EXPECT_THROW(qc->dump("tmp.qfr", qc::Binary, 4), qc::QFRException);
+	EXPECT_NO_THROW(qc->dump("tmp.qfr", qc::Binary, 1));
+}
@@ -8,6 +8,15 @@
 
 #include "QuantumComputation.hpp"
 #include "CircuitOptimizer.hpp"
+#include "PassManager.hpp"
+#include "FunctionalityCheckpoints.hpp"
+#include "StateSampler.hpp"
+#include "PauliExpectation.hpp"
+#include "DynamicCircuitSimulator.hpp"
+#include "SimulationSession.hpp"
+#include "StabilizerSimulator.hpp"
+#include "equivalence/RandomStimuliChecker.hpp"
+#include "equivalence/MiterBuilder.hpp"
 
 using namespace qc;
 
@@ -317,3 +326,1223 @@ TEST_F(QFRFunctionality, StripIdleAndDump) {
 	qc.print(actual);
 	EXPECT_EQ(goal.str(), actual.str());
 }
+
+TEST_F(QFRFunctionality, TombstoneEditing) {
+	unsigned short nqubits = 2;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<StandardOperation>(nqubits, 1, I);
+	qc.emplace_back<StandardOperation>(nqubits, qc::Control(0), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, 1, I);
+	qc.emplace_back<StandardOperation>(nqubits, 0, Z);
+
+	qc.markDeleted(1);
+	qc.markDeleted(3);
+	EXPECT_TRUE(qc.isDeleted(1));
+	EXPECT_FALSE(qc.isDeleted(2));
+	qc.replace(4, std::make_unique<StandardOperation>(nqubits, 0, Y));
+
+	std::vector<std::pair<std::size_t, std::unique_ptr<Operation>>> insertions{};
+	insertions.emplace_back(5, std::make_unique<StandardOperation>(nqubits, 1, T));
+	insertions.emplace_back(0, std::make_unique<StandardOperation>(nqubits, 1, X));
+	insertions.emplace_back(0, std::make_unique<StandardOperation>(nqubits, 1, S));
+	qc.insert(std::move(insertions));
+	EXPECT_EQ(qc.getNops(), 8);
+
+	EXPECT_EQ(qc.compact(), 2);
+	ASSERT_EQ(qc.getNops(), 6);
+	std::vector<OpType> expected{X, S, H, X, Y, T};
+	auto it = qc.begin();
+	for (auto type: expected) {
+		EXPECT_EQ((*it)->getType(), type);
+		++it;
+	}
+
+	std::vector<std::pair<std::size_t, std::unique_ptr<Operation>>> invalid{};
+	invalid.emplace_back(7, std::make_unique<StandardOperation>(nqubits, 1, T));
+	EXPECT_THROW(qc.insert(std::move(invalid)), QFRException);
+}
+
+TEST_F(QFRFunctionality, RemoveIdentitiesLinear) {
+	unsigned short nqubits = 1;
+	QuantumComputation qc(nqubits);
+	for (int i = 0; i < 100000; ++i) {
+		qc.emplace_back<StandardOperation>(nqubits, 0, (i % 2) ? X : I);
+	}
+	CircuitOptimizer::removeIdentities(qc);
+	EXPECT_EQ(qc.getNops(), 50000);
+	for (const auto& op: qc) {
+		EXPECT_EQ(op->getType(), X);
+	}
+}
+
+TEST_F(QFRFunctionality, DAGConstruction) {
+	unsigned short nqubits = 3;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);                    // 0
+	qc.emplace_back<StandardOperation>(nqubits, qc::Control(0), 1, X);   // 1
+	qc.emplace_back<StandardOperation>(nqubits, 2, Z);                    // 2
+	qc.emplace_back<StandardOperation>(nqubits, qc::Control(1), 2, X);   // 3
+	qc.emplace_back<NonUnitaryOperation>(nqubits, std::vector<unsigned short>{2}, std::vector<unsigned short>{0}); // 4
+	std::unique_ptr<Operation> op = std::make_unique<StandardOperation>(nqubits, 0, X);
+	qc.emplace_back<ClassicControlledOperation>(op, std::pair<unsigned short, unsigned short>{0, 1}, 1u); // 5
+
+	DAG dag(qc);
+	EXPECT_EQ(dag.size(), 6);
+	EXPECT_EQ(dag.getNwires(), 6);
+	EXPECT_EQ(dag.front(0), 0);
+	EXPECT_EQ(dag.back(0), 5);
+	EXPECT_EQ(dag.predecessor(1, 0), 0);
+	EXPECT_EQ(dag.predecessor(1, 1), DAG::NONE);
+	EXPECT_EQ(dag.predecessor(3, 2), 2);
+	EXPECT_EQ(dag.successor(1, 1), 3);
+	// the classically controlled operation depends on the measurement via the classical wire
+	EXPECT_EQ(dag.predecessor(5, 3), 4);
+	EXPECT_EQ(dag.predecessors(3), (std::vector<DAG::NodeId>{1, 2}));
+	EXPECT_EQ(dag.depth(), 5);
+
+	// remove node 1: its predecessors and successors get linked directly
+	dag.remove(1);
+	EXPECT_TRUE(dag.isRemoved(1));
+	EXPECT_TRUE(qc.isDeleted(1));
+	EXPECT_EQ(dag.front(1), 3);
+	EXPECT_EQ(dag.successor(0, 0), 5);
+	EXPECT_EQ(dag.predecessor(5, 0), 0);
+	EXPECT_EQ(dag.size(), 5);
+	std::vector<DAG::NodeId> nodes(dag.begin(), dag.end());
+	EXPECT_EQ(nodes, (std::vector<DAG::NodeId>{0, 2, 3, 4, 5}));
+
+	// replacements have to act on the same wires
+	EXPECT_THROW(dag.replace(2, std::make_unique<StandardOperation>(nqubits, 1, X)), QFRException);
+	EXPECT_NO_THROW(dag.replace(2, std::make_unique<StandardOperation>(nqubits, 2, Y)));
+	EXPECT_EQ(dag.at(2).getType(), Y);
+
+	dag.compact();
+	EXPECT_EQ(qc.getNops(), 5);
+	EXPECT_EQ(dag.getNnodes(), 5);
+	EXPECT_EQ(dag.predecessor(2, 2), 1);
+}
+
+TEST_F(QFRFunctionality, DAGInsertion) {
+	unsigned short nqubits = 3;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);                    // 0
+	qc.emplace_back<StandardOperation>(nqubits, qc::Control(0), 1, X);   // 1
+	qc.emplace_back<StandardOperation>(nqubits, 2, Z);                    // 2
+
+	DAG dag(qc);
+	const auto a = dag.insertBefore(1, std::make_unique<StandardOperation>(nqubits, 1, X));
+	EXPECT_EQ(a, 3);
+	EXPECT_EQ(dag.predecessor(a, 1), DAG::NONE);
+	EXPECT_EQ(dag.successor(a, 1), 1);
+	EXPECT_EQ(dag.predecessor(1, 1), a);
+	EXPECT_EQ(dag.front(1), a);
+	// the inserted operation is kept by the DAG until the circuit is compacted
+	EXPECT_EQ(qc.getNops(), 4);
+	EXPECT_FALSE(qc.isCompact());
+
+	const auto b = dag.insertAfter(2, std::make_unique<StandardOperation>(nqubits, qc::Control(2), 0, X));
+	EXPECT_EQ(dag.predecessor(b, 0), 1);
+	EXPECT_EQ(dag.predecessor(b, 2), 2);
+	EXPECT_EQ(dag.successor(1, 0), b);
+	EXPECT_EQ(dag.back(0), b);
+	const auto c = dag.insertBefore(DAG::NONE, std::make_unique<StandardOperation>(nqubits, 1, Y));
+	EXPECT_EQ(dag.predecessor(c, 1), 1);
+	EXPECT_EQ(dag.at(c).getType(), Y);
+	std::vector<DAG::NodeId> nodes(dag.begin(), dag.end());
+	EXPECT_EQ(nodes, (std::vector<DAG::NodeId>{0, a, 1, 2, b, c}));
+	EXPECT_EQ(dag.depth(), 3);
+
+	dag.remove(a);
+	EXPECT_EQ(dag.predecessor(1, 1), DAG::NONE);
+	auto extracted = dag.extract(2);
+	EXPECT_EQ(extracted->getType(), Z);
+	EXPECT_EQ(dag.predecessor(b, 2), DAG::NONE);
+
+	dag.compact();
+	EXPECT_TRUE(qc.isCompact());
+	ASSERT_EQ(qc.getNops(), 4);
+	auto it = qc.begin();
+	EXPECT_EQ((*it)->getType(), H);
+	EXPECT_EQ((*(++it))->getTargets().at(0), 1);
+	EXPECT_EQ((*(++it))->getTargets().at(0), 0);
+	EXPECT_EQ((*(++it))->getType(), Y);
+	EXPECT_EQ(dag.getNnodes(), 4);
+	EXPECT_EQ(dag.predecessor(2, 0), 1);
+}
+
+TEST_F(QFRFunctionality, SharedDAGPasses) {
+	unsigned short nqubits = 2;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<StandardOperation>(nqubits, 0, T);
+	qc.emplace_back<StandardOperation>(nqubits, 1, I);
+	qc.emplace_back<StandardOperation>(nqubits, qc::Control(0), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, qc::Control(1), 0, X);
+	qc.emplace_back<StandardOperation>(nqubits, qc::Control(0), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, 1, H);
+	auto e = qc.buildFunctionality(dd);
+
+	DAG dag(qc);
+	CircuitOptimizer::removeIdentities(dag);
+	CircuitOptimizer::swapGateFusion(dag);
+	CircuitOptimizer::singleGateFusion(dag);
+	dag.compact();
+
+	ASSERT_EQ(qc.getNops(), 3);
+	auto it = qc.begin();
+	EXPECT_TRUE((*it)->isCompoundOperation());
+	++it;
+	EXPECT_EQ((*it)->getType(), SWAP);
+	++it;
+	EXPECT_EQ((*it)->getType(), H);
+	auto f = qc.buildFunctionality(dd);
+	EXPECT_TRUE(dd::Package::equals(e, f));
+}
+
+TEST_F(QFRFunctionality, SharedDAGPassesWithInsertions) {
+	unsigned short nqubits = 3;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, T);
+	qc.emplace_back<StandardOperation>(nqubits, qc::Control(0), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, qc::Control(1), 0, X);
+	qc.emplace_back<StandardOperation>(nqubits, qc::Control(0), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, 1, T);
+	qc.emplace_back<StandardOperation>(nqubits, 2, H);
+	qc.emplace_back<StandardOperation>(nqubits, qc::Control(2), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, 1, RY, 0.2);
+	auto e = qc.buildFunctionality(dd);
+
+	DAG dag(qc);
+	CircuitOptimizer::eliminateSwaps(dag);
+	CircuitOptimizer::mergeRotations(dag);
+	CircuitOptimizer::consolidateBlocks(dag, 2);
+	EXPECT_FALSE(qc.isCompact());
+	dag.compact();
+
+	// after relabeling, both T gates act on qubit 0 and merge, then all gates form a single block
+	ASSERT_EQ(qc.getNops(), 1);
+	auto it = qc.begin();
+	const auto* block = dynamic_cast<MatrixOperation*>(it->get());
+	ASSERT_NE(block, nullptr);
+	EXPECT_EQ(block->getQubits(), (std::vector<unsigned short>{0, 2}));
+	EXPECT_EQ(std::distance(block->begin(), block->end()), 4);
+	auto f = qc.buildFunctionality(dd);
+	EXPECT_TRUE(dd::Package::equals(e, f));
+
+	// operations depending on the order of the qubits get explicit SWAPs inserted before them
+	QuantumComputation qc2(nqubits);
+	qc2.emplace_back<StandardOperation>(nqubits, std::vector<Control>{}, 0, 1, SWAP);
+	qc2.emplace_back<StandardOperation>(nqubits, 1, H);
+	qc2.emplace_back<NonUnitaryOperation>(nqubits);
+	DAG dag2(qc2);
+	CircuitOptimizer::eliminateSwaps(dag2);
+	dag2.compact();
+	ASSERT_EQ(qc2.getNops(), 3);
+	it = qc2.begin();
+	EXPECT_EQ((*it)->getTargets().at(0), 0);
+	EXPECT_EQ((*(++it))->getType(), SWAP);
+	EXPECT_EQ((*(++it))->getType(), ShowProbabilities);
+	EXPECT_EQ(dag2.predecessor(2, 0), 1);
+}
+
+TEST_F(QFRFunctionality, CancelInverseGatesAcrossCommutingGates) {
+	unsigned short nqubits = 3;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, T);
+	qc.emplace_back<StandardOperation>(nqubits, qc::Control(0), 1, X);    // T commutes with the control
+	qc.emplace_back<StandardOperation>(nqubits, 2, H);                     // disjoint qubits
+	qc.emplace_back<StandardOperation>(nqubits, 0, Tdag);
+	qc.emplace_back<StandardOperation>(nqubits, qc::Control(2), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, 1, RX, 0.3);              // X-like on the target
+	qc.emplace_back<StandardOperation>(nqubits, qc::Control(2), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, 0, U3, 0.1, 0.2, 0.3);
+	qc.emplace_back<StandardOperation>(nqubits, 0, U3, -0.2, -0.1, -0.3);
+	auto e = qc.buildFunctionality(dd);
+
+	CircuitOptimizer::cancelInverseGates(qc);
+	auto f = qc.buildFunctionality(dd);
+	EXPECT_EQ(qc.getNops(), 3);
+	EXPECT_TRUE(dd::Package::equals(e, f));
+}
+
+TEST_F(QFRFunctionality, CancelInverseGatesBlocked) {
+	unsigned short nqubits = 2;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<StandardOperation>(nqubits, 0, Z);                     // does not commute with H
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<StandardOperation>(nqubits, 1, S);
+	qc.emplace_back<StandardOperation>(nqubits, qc::Control(0), 1, X);    // S does not commute with the target
+	qc.emplace_back<StandardOperation>(nqubits, 1, Sdag);
+	CircuitOptimizer::cancelInverseGates(qc);
+	EXPECT_EQ(qc.getNops(), 6);
+
+	QuantumComputation qc2(nqubits);
+	qc2.emplace_back<StandardOperation>(nqubits, 0, X);
+	qc2.emplace_back<StandardOperation>(nqubits, 0, RX, 0.1);
+	qc2.emplace_back<StandardOperation>(nqubits, 0, RX, 0.2);
+	qc2.emplace_back<StandardOperation>(nqubits, 0, X);
+	CircuitOptimizer::cancelInverseGates(qc2, 2);
+	EXPECT_EQ(qc2.getNops(), 4);
+	CircuitOptimizer::cancelInverseGates(qc2, 3);
+	EXPECT_EQ(qc2.getNops(), 2);
+}
+
+TEST_F(QFRFunctionality, FuseSingleQubitGatesNumerically) {
+	unsigned short nqubits = 2;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<StandardOperation>(nqubits, 0, T);
+	qc.emplace_back<StandardOperation>(nqubits, 0, RY, 0.3);
+	qc.emplace_back<StandardOperation>(nqubits, qc::Control(0), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, 1, U3, 0.1, 0.2, 0.3);
+	qc.emplace_back<StandardOperation>(nqubits, 1, V);
+	qc.emplace_back<StandardOperation>(nqubits, 0, S);
+	qc.emplace_back<StandardOperation>(nqubits, 0, Sdag);
+	auto e = qc.buildFunctionality(dd);
+
+	CircuitOptimizer::singleGateFusion(qc, true);
+	auto f = qc.buildFunctionality(dd);
+	// S and Sdag cancel
+	EXPECT_EQ(qc.getNops(), 3);
+	for (const auto& op: qc) {
+		EXPECT_TRUE(op->isStandardOperation());
+	}
+	// global phases are dropped
+	EXPECT_EQ(e.p, f.p);
+	EXPECT_NEAR(CN::mag(e.w), CN::mag(f.w), CN::TOLERANCE);
+}
+
+TEST_F(QFRFunctionality, FuseToNamedGate) {
+	unsigned short nqubits = 1;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, T);
+	qc.emplace_back<StandardOperation>(nqubits, 0, T);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<StandardOperation>(nqubits, 0, Z);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	CircuitOptimizer::singleGateFusion(qc, true);
+	ASSERT_EQ(qc.getNops(), 1);
+	// S * H * Z * H = S * X
+	auto op = qc.begin()->get();
+	auto expected = StandardOperation(nqubits, 0, U3, qc::PI_2, qc::PI, qc::PI);
+	auto m = dynamic_cast<StandardOperation*>(op)->getGateMatrix();
+	auto n = expected.getGateMatrix();
+	// equal up to global phase
+	for (std::size_t i = 0; i < m.size(); ++i) {
+		EXPECT_NEAR(std::hypot(m[i].r, m[i].i), std::hypot(n[i].r, n[i].i), 1e-9);
+	}
+
+	QuantumComputation qc2(nqubits);
+	qc2.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc2.emplace_back<StandardOperation>(nqubits, 0, Z);
+	qc2.emplace_back<StandardOperation>(nqubits, 0, H);
+	CircuitOptimizer::singleGateFusion(qc2, true);
+	ASSERT_EQ(qc2.getNops(), 1);
+	EXPECT_EQ((*qc2.begin())->getType(), X);
+}
+
+TEST_F(QFRFunctionality, ConsolidateTwoQubitBlocks) {
+	unsigned short nqubits = 3;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, 1, RZ, 0.3);
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, 2, T);
+	qc.emplace_back<StandardOperation>(nqubits, Control(1, Control::neg), 2, Y);
+	qc.emplace_back<StandardOperation>(nqubits, 2, U3, 0.1, 0.2, 0.3);
+	qc.emplace_back<StandardOperation>(nqubits, std::vector<Control>{Control(0)}, 1, 2, SWAP);
+	auto e = qc.buildFunctionality(dd);
+	std::stringstream original{};
+	qc.dumpOpenQASM(original);
+
+	CircuitOptimizer::consolidateBlocks(qc, 2);
+	// {H, CX, RZ, CX} on qubits 0 and 1, T, {CY, U3} on qubits 1 and 2, and the Fredkin gate
+	ASSERT_EQ(qc.getNops(), 4);
+	auto it = qc.begin();
+	EXPECT_EQ(dynamic_cast<MatrixOperation*>(it->get())->getQubits(), (std::vector<unsigned short>{0, 1}));
+	EXPECT_EQ((*(++it))->getType(), T);
+	EXPECT_EQ(dynamic_cast<MatrixOperation*>((++it)->get())->getQubits(), (std::vector<unsigned short>{1, 2}));
+	EXPECT_EQ((*(++it))->getType(), SWAP);
+	auto f = qc.buildFunctionality(dd);
+	EXPECT_TRUE(dd->equals(e, f));
+
+	// exporting falls back to the original gates
+	std::stringstream consolidated{};
+	qc.dumpOpenQASM(consolidated);
+	EXPECT_EQ(original.str(), consolidated.str());
+
+	// up to three qubits, everything ends up in one block
+	QuantumComputation qc2(nqubits);
+	qc2.import(original, OpenQASM);
+	CircuitOptimizer::consolidateBlocks(qc2, 3);
+	ASSERT_EQ(qc2.getNops(), 1);
+	auto g = qc2.buildFunctionality(dd);
+	EXPECT_TRUE(dd->equals(e, g));
+}
+
+TEST_F(QFRFunctionality, MatrixOperationFromMatrix) {
+	unsigned short nqubits = 3;
+	// controlled-Z between qubits 0 and 2
+	MatrixOperation::Matrix cz(16, 0);
+	cz[0] = cz[5] = cz[10] = 1;
+	cz[15] = -1;
+	MatrixOperation op(nqubits, {2, 0}, cz);
+	StandardOperation reference(nqubits, Control(0), 2, Z);
+	auto e = op.getDD(dd, line);
+	auto f = reference.getDD(dd, line);
+	EXPECT_TRUE(dd->equals(e, f));
+
+	std::map<unsigned short, unsigned short> permutation{{0, 1}, {1, 0}, {2, 2}};
+	line.fill(LINE_DEFAULT);
+	auto g = op.getInverseDD(dd, line, permutation);
+	line.fill(LINE_DEFAULT);
+	auto h = reference.getDD(dd, line, permutation);
+	EXPECT_TRUE(dd->equals(g, h));
+
+	// there is no gate decomposition
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<MatrixOperation>(nqubits, std::vector<unsigned short>{0, 2}, cz);
+	std::stringstream ss{};
+	EXPECT_THROW(qc.dumpOpenQASM(ss), QFRException);
+	EXPECT_THROW(MatrixOperation(nqubits, {0, 1}, MatrixOperation::Matrix(4, 1)), QFRException);
+}
+
+TEST_F(QFRFunctionality, MergeRotationsAcrossCNOTs) {
+	unsigned short nqubits = 2;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 1, T);                  // x1
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, 1, S);                  // x0 + x1
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, 1, Tdag);               // x1
+	qc.emplace_back<StandardOperation>(nqubits, Control(1), 0, X);
+	qc.emplace_back<StandardOperation>(nqubits, 0, RZ, 0.3);            // x0 + x1
+	qc.emplace_back<StandardOperation>(nqubits, 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, 1, T);                  // x1 + 1
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, 1, T);                  // x1 + 1
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<StandardOperation>(nqubits, 0, Z);                  // new variable
+	qc.emplace_back<StandardOperation>(nqubits, 1, T);                  // new variable
+	auto e = qc.buildFunctionality(dd);
+
+	CircuitOptimizer::mergeRotations(qc);
+	// T and Tdag cancel, S and RZ merge, both T on the negated parity merge into S
+	EXPECT_EQ(qc.getNops(), 11);
+	std::size_t nrotations = 0;
+	for (const auto& op: qc) {
+		if (op->getType() != X && op->getType() != H) {
+			++nrotations;
+		}
+	}
+	EXPECT_EQ(nrotations, 4);
+	auto f = qc.buildFunctionality(dd);
+	EXPECT_TRUE(dd->equals(e, f));
+}
+
+TEST_F(QFRFunctionality, EliminateSwaps) {
+	unsigned short nqubits = 3;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<StandardOperation>(nqubits, std::vector<Control>{}, 0, 1, SWAP);
+	qc.emplace_back<StandardOperation>(nqubits, 1, T);
+	qc.emplace_back<StandardOperation>(nqubits, Control(1), 2, X);
+	qc.emplace_back<StandardOperation>(nqubits, Control(2), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, Control(1), 2, X);
+	qc.emplace_back<StandardOperation>(nqubits, 2, Y);
+	qc.emplace_back<StandardOperation>(nqubits, Control(2), 1, X);
+	auto e = qc.buildFunctionality(dd);
+
+	CircuitOptimizer::eliminateSwaps(qc);
+	// the contents of qubit 0 end up on qubit 2
+	ASSERT_EQ(qc.getNops(), 4);
+	for (const auto& op: qc) {
+		EXPECT_NE(op->getType(), SWAP);
+	}
+	auto it = qc.begin();
+	EXPECT_EQ((*(++it))->getTargets().at(0), 0);
+	EXPECT_EQ((*(++it))->getTargets().at(0), 0);
+	EXPECT_EQ((*(++it))->getControls().at(0).qubit, 0);
+	EXPECT_EQ((*it)->getTargets().at(0), 2);
+	EXPECT_EQ(qc.outputPermutation, (permutationMap{{0, 2}, {1, 0}, {2, 1}}));
+	auto f = qc.buildFunctionality(dd);
+	EXPECT_TRUE(dd->equals(e, f));
+
+	// matrix operations are relabeled as well
+	QuantumComputation qc2(nqubits);
+	qc2.emplace_back<StandardOperation>(nqubits, std::vector<Control>{}, 0, 2, SWAP);
+	qc2.emplace_back<StandardOperation>(nqubits, 0, RY, 0.4);
+	qc2.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+	qc2.emplace_back<StandardOperation>(nqubits, 1, T);
+	auto g = qc2.buildFunctionality(dd);
+	CircuitOptimizer::consolidateBlocks(qc2);
+	CircuitOptimizer::eliminateSwaps(qc2);
+	ASSERT_EQ(qc2.getNops(), 1);
+	EXPECT_EQ(dynamic_cast<MatrixOperation*>(qc2.begin()->get())->getQubits(), (std::vector<unsigned short>{1, 2}));
+	auto h = qc2.buildFunctionality(dd);
+	EXPECT_TRUE(dd->equals(g, h));
+}
+
+TEST_F(QFRFunctionality, PassManagerFixpoint) {
+	unsigned short nqubits = 3;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<StandardOperation>(nqubits, 1, T);
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, 2, Z);
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, 1, Tdag);
+	qc.emplace_back<StandardOperation>(nqubits, std::vector<Control>{}, 1, 2, SWAP);
+	qc.emplace_back<StandardOperation>(nqubits, 2, H);
+	qc.emplace_back<StandardOperation>(nqubits, 2, S);
+	qc.emplace_back<StandardOperation>(nqubits, Control(2), 0, X);
+	auto e = qc.buildFunctionality(dd);
+
+	auto pm = PassManager::fast();
+	pm.run(qc);
+	EXPECT_TRUE(pm.hasConverged());
+	// CX pair, then T and Tdag cancel, H and S are fused
+	EXPECT_EQ(qc.getNops(), 5);
+	const auto& stats = pm.getStatistics();
+	ASSERT_EQ(stats.size(), pm.getIterations() * pm.getNpasses());
+	EXPECT_EQ(stats.front().before.nops, 10);
+	EXPECT_EQ(stats.front().before.nmultiQubit, 4);
+	EXPECT_EQ(stats.back().after.nops, 5);
+	EXPECT_EQ(stats.back().after.nmultiQubit, 2);
+	auto f = qc.buildFunctionality(dd);
+	EXPECT_EQ(e.p, f.p);
+
+	std::stringstream ss{};
+	pm.printStatistics(ss);
+	EXPECT_NE(ss.str().find("\"name\": \"cancelInverseGates\""), std::string::npos);
+	EXPECT_NE(ss.str().find("\"converged\": true"), std::string::npos);
+
+	auto aggressive = PassManager::aggressive();
+	aggressive.run(qc);
+	// the SWAP is eliminated and the remaining gates are consolidated into a single block
+	EXPECT_EQ(qc.getNops(), 2);
+	EXPECT_TRUE(qc.isCompact());
+	EXPECT_EQ(aggressive.getStatistics().back().name, "consolidateBlocks");
+	// a matrix operation counts as a single (multi-qubit) operation
+	EXPECT_EQ(aggressive.getStatistics().back().after.nops, 2);
+	EXPECT_EQ(aggressive.getStatistics().back().after, CircuitMetrics::of(qc));
+	auto g = qc.buildFunctionality(dd);
+	EXPECT_EQ(e.p, g.p);
+
+	// custom passes work on the shared dependency graph
+	QuantumComputation qc2(nqubits);
+	qc2.emplace_back<StandardOperation>(nqubits, 0, I);
+	qc2.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc2.emplace_back<StandardOperation>(nqubits, 0, H);
+	PassManager custom{};
+	custom.addPass("removeIdentities", [](DAG& dag) { CircuitOptimizer::removeIdentities(dag); });
+	custom.addPass("cancelInverseGates", [](DAG& dag) { CircuitOptimizer::cancelInverseGates(dag); });
+	custom.run(qc2);
+	EXPECT_EQ(qc2.getNops(), 0);
+	EXPECT_EQ(custom.getStatistics().front().after.nops, 2);
+}
+
+TEST_F(QFRFunctionality, ScheduleForDDSize) {
+	unsigned short nqubits = 3;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 2, X);
+	qc.emplace_back<StandardOperation>(nqubits, 0, Z);
+	qc.emplace_back<StandardOperation>(nqubits, 1, H);
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 2, X);
+	qc.emplace_back<StandardOperation>(nqubits, 2, H);
+	qc.emplace_back<StandardOperation>(nqubits, Control(1), 2, Z);
+	auto e = qc.buildFunctionality(dd);
+
+	CircuitOptimizer::scheduleForDDSize(qc, dd);
+	ASSERT_EQ(qc.getNops(), 6);
+	auto f = qc.buildFunctionality(dd);
+	EXPECT_TRUE(dd->equals(e, f));
+
+	std::vector<std::size_t> cx{};
+	std::size_t h2 = 0, cz = 0, i = 0;
+	for (const auto& op: qc) {
+		if (op->getType() == X) cx.emplace_back(i);
+		if (op->getType() == H && op->getTargets().at(0) == 2) h2 = i;
+		if (op->getType() == Z && op->getNcontrols() == 1) cz = i;
+		++i;
+	}
+	// the two CNOTs commute with the Z gate and cancel each other, which keeps the DD small
+	ASSERT_EQ(cx.size(), 2);
+	EXPECT_EQ(cx[1], cx[0] + 1);
+	// H and CZ do not commute and must not be swapped
+	EXPECT_LT(cx[1], h2);
+	EXPECT_LT(h2, cz);
+}
+
+TEST_F(QFRFunctionality, StaticVariableOrder) {
+	unsigned short nqubits = 4;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 3, X);
+	qc.emplace_back<StandardOperation>(nqubits, 1, H);
+	qc.emplace_back<StandardOperation>(nqubits, Control(1), 2, X);
+	qc.emplace_back<StandardOperation>(nqubits, 3, T);
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 3, X);
+	qc.emplace_back<StandardOperation>(nqubits, Control(1), 2, Z);
+	qc.emplace_back<StandardOperation>(nqubits, 2, RY, 0.4);
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 3, Y);
+
+	auto varMap = qc.computeStaticVariableOrder();
+	// interacting qubits are adjacent and the control qubit 0 is above its target
+	EXPECT_EQ(std::abs(varMap.at(0) - varMap.at(3)), 1);
+	EXPECT_EQ(std::abs(varMap.at(1) - varMap.at(2)), 1);
+	EXPECT_GT(varMap.at(0), varMap.at(3));
+
+	auto e = qc.buildFunctionality(dd);
+	dd::Edge f{};
+	permutationMap resultMap{};
+	std::tie(f, resultMap) = qc.buildFunctionality(dd, dd::None, varMap);
+	for (unsigned short q = 0; q < nqubits; ++q) {
+		EXPECT_EQ(resultMap.at(q), varMap.at(q));
+	}
+
+	// entry (i, j) of the original functionality corresponds to entry (pi(i), pi(j)) of the reordered one
+	auto permute = [&](unsigned long long index) {
+		unsigned long long result = 0;
+		for (unsigned short q = 0; q < nqubits; ++q) {
+			result |= ((index >> q) & 1ull) << varMap.at(q);
+		}
+		return result;
+	};
+	auto value = [&](const dd::Edge& edge, unsigned long long i, unsigned long long j) {
+		auto c = qc.getEntry(dd, edge, i, j);
+		return std::complex<fp>(CN::val(c.r), CN::val(c.i)) * std::complex<fp>(CN::val(edge.w.r), CN::val(edge.w.i));
+	};
+	for (unsigned long long i = 0; i < (1ull << nqubits); ++i) {
+		for (unsigned long long j = 0; j < (1ull << nqubits); ++j) {
+			EXPECT_NEAR(std::abs(value(e, i, j) - value(f, permute(i), permute(j))), 0., 1e-9);
+		}
+	}
+
+	EXPECT_THROW(qc.buildFunctionality(dd, dd::None, permutationMap{{0, 0}, {1, 0}, {2, 1}, {3, 2}}), QFRException);
+}
+
+TEST_F(QFRFunctionality, BuildFunctionalityByComponents) {
+	unsigned short nqubits = 5;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 3, X);
+	qc.emplace_back<StandardOperation>(nqubits, 1, H);
+	qc.emplace_back<StandardOperation>(nqubits, Control(1), 2, X);
+	qc.emplace_back<StandardOperation>(nqubits, 3, T);
+	qc.emplace_back<NonUnitaryOperation>(nqubits, std::vector<unsigned short>{0, 1, 2, 3, 4}, Barrier);
+	qc.emplace_back<StandardOperation>(nqubits, 2, RY, 0.4);
+	qc.emplace_back<StandardOperation>(nqubits, Control(3), 0, Y);
+
+	auto components = qc.getConnectedComponents();
+	ASSERT_EQ(components.size(), 3);
+	EXPECT_EQ(components[0], (std::vector<unsigned short>{0, 3}));
+	EXPECT_EQ(components[1], (std::vector<unsigned short>{1, 2}));
+	EXPECT_EQ(components[2], (std::vector<unsigned short>{4}));
+
+	// entries are read with respect to the standard layout
+	QuantumComputation reference(nqubits);
+	auto check = [&]() {
+		auto e = qc.buildFunctionality(dd);
+		for (unsigned int nthreads: {1u, 2u}) {
+			dd::Edge f{};
+			permutationMap varMap{};
+			std::tie(f, varMap) = qc.buildFunctionalityByComponents(dd, nthreads);
+			EXPECT_EQ(varMap.at(0), 0);
+			EXPECT_EQ(varMap.at(3), 1);
+			EXPECT_EQ(varMap.at(1), 2);
+			EXPECT_EQ(varMap.at(2), 3);
+			EXPECT_EQ(varMap.at(4), 4);
+
+			auto permute = [&](unsigned long long index) {
+				unsigned long long result = 0;
+				for (unsigned short q = 0; q < nqubits; ++q) {
+					result |= ((index >> q) & 1ull) << varMap.at(q);
+				}
+				return result;
+			};
+			auto value = [&](const dd::Edge& edge, unsigned long long i, unsigned long long j) {
+				auto c = reference.getEntry(dd, edge, i, j);
+				return std::complex<fp>(CN::val(c.r), CN::val(c.i)) * std::complex<fp>(CN::val(edge.w.r), CN::val(edge.w.i));
+			};
+			for (unsigned long long i = 0; i < (1ull << nqubits); ++i) {
+				for (unsigned long long j = 0; j < (1ull << nqubits); ++j) {
+					EXPECT_NEAR(std::abs(value(e, i, j) - value(f, permute(i), permute(j))), 0., 1e-9);
+				}
+			}
+		}
+	};
+	check();
+
+	// garbage outputs do not prevent the decomposition
+	qc.outputPermutation.erase(2);
+	qc.outputPermutation.erase(4);
+	check();
+
+	// an output permutation mixing the components requires building the functionality as a whole
+	qc.outputPermutation = {{0, 1}, {1, 0}, {2, 2}, {3, 3}, {4, 4}};
+	auto result = qc.buildFunctionalityByComponents(dd);
+	EXPECT_EQ(result.second, Operation::standardPermutation);
+	dd->decRef(result.first);
+}
+
+TEST_F(QFRFunctionality, LightConeSimulation) {
+	unsigned short nqubits = 4;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<StandardOperation>(nqubits, 2, H);
+	qc.emplace_back<StandardOperation>(nqubits, Control(2), 3, X);
+	qc.emplace_back<StandardOperation>(nqubits, 3, T);
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, 1, RY, 0.3);
+	qc.emplace_back<StandardOperation>(nqubits, std::vector<unsigned short>{1, 2}, SWAP);
+
+	EXPECT_EQ(qc.lightCone({0}), (std::vector<bool>{true, false, false, false, true, false, false}));
+	EXPECT_EQ(qc.lightCone({2}), (std::vector<bool>{true, false, false, false, true, true, true}));
+	EXPECT_EQ(qc.lightCone({3}), (std::vector<bool>{false, true, true, true, false, false, false}));
+	EXPECT_THROW(qc.lightCone({7}), QFRException);
+
+	auto probabilityOfOne = [&](const dd::Edge& e, unsigned short q) {
+		fp p = 0.;
+		for (unsigned long long i = 0; i < (1ull << nqubits); ++i) {
+			if ((i >> q) & 1ull) {
+				auto c = qc.getEntry(dd, e, i, 0);
+				p += std::norm(std::complex<fp>(CN::val(c.r), CN::val(c.i)) * std::complex<fp>(CN::val(e.w.r), CN::val(e.w.i)));
+			}
+		}
+		return p;
+	};
+	auto full = qc.simulate(dd->makeZeroState(nqubits), dd);
+	for (unsigned short q = 0; q < nqubits; ++q) {
+		auto pruned = qc.simulateLightCone(dd->makeZeroState(nqubits), dd, {q});
+		EXPECT_NEAR(probabilityOfOne(pruned, q), probabilityOfOne(full, q), 1e-9);
+	}
+}
+
+TEST_F(QFRFunctionality, StateSampling) {
+	unsigned short nqubits = 3;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+	auto e = qc.simulate(dd->makeZeroState(nqubits), dd);
+
+	StateSampler sampler(e, nqubits);
+	EXPECT_NEAR(sampler.getNorm(), 1., 1e-9);
+	const std::size_t shots = 10000;
+	auto counts = sampler.sample(shots, 4, 42);
+	ASSERT_EQ(counts.size(), 2);
+	EXPECT_EQ(counts["000"] + counts["011"], shots);
+	EXPECT_NEAR(static_cast<double>(counts["011"]) / shots, 0.5, 0.05);
+	EXPECT_EQ(counts, sampler.sample(shots, 4, 42));
+
+	// sampling respects the variable order of the state
+	QuantumComputation qc2(nqubits);
+	qc2.emplace_back<StandardOperation>(nqubits, 0, X);
+	permutationMap varMap{{0, 2}, {1, 1}, {2, 0}};
+	dd::Edge f{};
+	std::tie(f, varMap) = qc2.simulate(dd->makeZeroState(nqubits), dd, dd::None, varMap);
+	StateSampler sampler2(f, nqubits, varMap);
+	std::mt19937_64 rng(0);
+	EXPECT_EQ(sampler2.sample(rng), "001");
+}
+
+TEST_F(QFRFunctionality, PauliExpectationValues) {
+	unsigned short nqubits = 3;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, 2, RY, 0.4);
+	auto e = qc.simulate(dd->makeZeroState(nqubits), dd);
+
+	PauliExpectation pe(e, nqubits);
+	EXPECT_NEAR(pe.expectation("III"), 1., 1e-9);
+	EXPECT_NEAR(pe.expectation("IZZ"), 1., 1e-9);
+	EXPECT_NEAR(pe.expectation("IIZ"), 0., 1e-9);
+	EXPECT_NEAR(pe.expectation("ZII"), std::cos(0.4), 1e-9);
+
+	auto values = pe.expectation(std::vector<std::string>{"IXX", "IYY", "XII", "XZZ", "YII"});
+	ASSERT_EQ(values.size(), 5);
+	EXPECT_NEAR(values[0], 1., 1e-9);
+	EXPECT_NEAR(values[1], -1., 1e-9);
+	EXPECT_NEAR(values[2], std::sin(0.4), 1e-9);
+	EXPECT_NEAR(values[3], std::sin(0.4), 1e-9);
+	EXPECT_NEAR(values[4], 0., 1e-9);
+	EXPECT_GT(pe.getCacheSize(), 0);
+
+	PauliExpectation::Observable observable{{0.5, "IZZ"}, {-2., "ZII"}};
+	EXPECT_NEAR(pe.expectation(observable), 0.5 - 2. * std::cos(0.4), 1e-9);
+
+	EXPECT_THROW(pe.expectation("ZZ"), QFRException);
+	EXPECT_THROW(pe.expectation("ZAZ"), QFRException);
+}
+
+TEST_F(QFRFunctionality, SnapshotsAndMarginalProbabilities) {
+	unsigned short nqubits = 2;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<NonUnitaryOperation>(nqubits, std::vector<unsigned short>{0, 1}, 1);
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+	qc.emplace_back<NonUnitaryOperation>(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 1, X);
+
+	auto expectProbabilities = [](const std::vector<fp>& actual, const std::vector<fp>& expected) {
+		ASSERT_EQ(actual.size(), expected.size());
+		for (std::size_t i = 0; i < expected.size(); ++i) {
+			EXPECT_NEAR(actual[i], expected[i], 1e-9);
+		}
+	};
+
+	std::vector<StateSnapshot> snapshots{};
+	auto e = qc.simulate(dd->makeZeroState(nqubits), dd, snapshots);
+	ASSERT_EQ(snapshots.size(), 2);
+	EXPECT_EQ(snapshots[0].op, 1);
+	EXPECT_EQ(snapshots[0].type, Snapshot);
+	EXPECT_EQ(snapshots[0].id, 1);
+	EXPECT_EQ(snapshots[1].type, ShowProbabilities);
+	expectProbabilities(QuantumComputation::getMarginalProbabilities(snapshots[0].state, {0}, snapshots[0].varMap), {0.5, 0.5});
+	expectProbabilities(QuantumComputation::getMarginalProbabilities(snapshots[0].state, {1}, snapshots[0].varMap), {1., 0.});
+	expectProbabilities(QuantumComputation::getMarginalProbabilities(snapshots[1]), {0.5, 0., 0., 0.5});
+	expectProbabilities(QuantumComputation::getMarginalProbabilities(e, {1}), {0.5, 0.5});
+	expectProbabilities(QuantumComputation::getMarginalProbabilities(e, {0, 1}), {0., 0.5, 0.5, 0.});
+	expectProbabilities(QuantumComputation::getMarginalProbabilities(e, {1, 0}), {0., 0.5, 0.5, 0.});
+	QuantumComputation::releaseSnapshots(dd, snapshots);
+	EXPECT_TRUE(snapshots.empty());
+
+	// the overload supporting a variable order no longer rejects these operations
+	dd::Edge f{};
+	permutationMap varMap{};
+	std::tie(f, varMap) = qc.simulate(dd->makeZeroState(nqubits), dd, dd::None, Operation::standardPermutation, snapshots);
+	EXPECT_EQ(snapshots.size(), 2);
+	expectProbabilities(QuantumComputation::getMarginalProbabilities(f, {0, 1}, varMap), {0., 0.5, 0.5, 0.});
+	QuantumComputation::releaseSnapshots(dd, snapshots);
+
+	EXPECT_THROW(QuantumComputation::getMarginalProbabilities(e, {0, 0}), QFRException);
+}
+
+TEST_F(QFRFunctionality, DynamicCircuitSimulation) {
+	unsigned short nqubits = 2;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<NonUnitaryOperation>(nqubits, std::vector<unsigned short>{0}, std::vector<unsigned short>{0});
+	std::unique_ptr<Operation> op = std::make_unique<StandardOperation>(nqubits, 1, X);
+	std::pair<unsigned short, unsigned short> controlRegister{0, 2};
+	qc.emplace_back<ClassicControlledOperation>(op, controlRegister, 1);
+	qc.emplace_back<NonUnitaryOperation>(nqubits, std::vector<unsigned short>{0}, Reset);
+	qc.emplace_back<NonUnitaryOperation>(nqubits, std::vector<unsigned short>{1}, std::vector<unsigned short>{1});
+
+	DynamicCircuitSimulator sim(qc, dd, 42);
+	auto branches = sim.simulateBranches(dd->makeZeroState(nqubits));
+	ASSERT_EQ(branches.size(), 2);
+	std::sort(branches.begin(), branches.end(), [](const auto& a, const auto& b) { return a.classical < b.classical; });
+	EXPECT_EQ(branches[0].classical, "00");
+	EXPECT_EQ(branches[1].classical, "11");
+	EXPECT_NEAR(branches[0].probability, 0.5, 1e-9);
+	EXPECT_NEAR(branches[1].probability, 0.5, 1e-9);
+	// qubit 0 has been reset and qubit 1 has been flipped according to the first measurement
+	auto probabilities = QuantumComputation::getMarginalProbabilities(branches[1].state, {0, 1});
+	EXPECT_NEAR(probabilities[2], 1., 1e-9);
+	probabilities = QuantumComputation::getMarginalProbabilities(branches[0].state, {0, 1});
+	EXPECT_NEAR(probabilities[0], 1., 1e-9);
+	DynamicCircuitSimulator::releaseBranches(dd, branches);
+
+	auto shot = sim.simulateShot(dd->makeZeroState(nqubits));
+	EXPECT_TRUE(shot.classical == "00" || shot.classical == "11");
+	EXPECT_NEAR(shot.probability, 0.5, 1e-9);
+	dd->decRef(shot.state);
+
+	// the threshold refers to the probability of the whole branch, not of the individual outcomes
+	QuantumComputation uniform(nqubits);
+	uniform.emplace_back<StandardOperation>(nqubits, 0, H);
+	uniform.emplace_back<StandardOperation>(nqubits, 1, H);
+	uniform.emplace_back<NonUnitaryOperation>(nqubits, std::vector<unsigned short>{0, 1}, std::vector<unsigned short>{0, 1});
+	DynamicCircuitSimulator uniformSim(uniform, dd);
+	branches = uniformSim.simulateBranches(dd->makeZeroState(nqubits), 0.3);
+	EXPECT_TRUE(branches.empty());
+	branches = uniformSim.simulateBranches(dd->makeZeroState(nqubits), 0.2);
+	EXPECT_EQ(branches.size(), 4);
+	DynamicCircuitSimulator::releaseBranches(dd, branches);
+
+	const std::size_t shots = 2000;
+	for (const auto& counts: {sim.sampleBranching(dd->makeZeroState(nqubits), shots), sim.sampleTrajectories(dd->makeZeroState(nqubits), shots)}) {
+		EXPECT_EQ(counts.size(), 2);
+		EXPECT_EQ(counts.at("00") + counts.at("11"), shots);
+		EXPECT_NEAR(static_cast<double>(counts.at("11")) / shots, 0.5, 0.05);
+	}
+}
+
+TEST_F(QFRFunctionality, SimulateBatch) {
+	unsigned short nqubits = 3;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 2, X);
+	qc.emplace_back<StandardOperation>(nqubits, 1, RY, 0.7);
+	qc.emplace_back<StandardOperation>(nqubits, std::vector<unsigned short>{1, 2}, SWAP);
+	qc.emplace_back<StandardOperation>(nqubits, Control(1), 0, Z);
+
+	std::vector<dd::Edge> inputs{};
+	for (unsigned long long i = 0; i < (1ull << nqubits); ++i) {
+		inputs.emplace_back(dd->makeBasisState(nqubits, std::bitset<dd::MAXN>(i)));
+	}
+	auto results = qc.simulateBatch(inputs, dd);
+	ASSERT_EQ(results.size(), inputs.size());
+	for (std::size_t i = 0; i < inputs.size(); ++i) {
+		auto expected = qc.simulate(inputs[i], dd);
+		EXPECT_EQ(results[i].p, expected.p);
+		EXPECT_TRUE(CN::equals(results[i].w, expected.w));
+	}
+	EXPECT_TRUE(qc.simulateBatch({}, dd).empty());
+}
+
+TEST_F(QFRFunctionality, RandomStimuliEquivalenceChecking) {
+	unsigned short nqubits = 2;
+	QuantumComputation qc1(nqubits);
+	qc1.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc1.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+
+	// same functionality with the logical qubits placed on swapped physical qubits
+	QuantumComputation qc2(nqubits);
+	qc2.emplace_back<StandardOperation>(nqubits, 1, H);
+	qc2.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc2.emplace_back<StandardOperation>(nqubits, Control(1), 0, Z);
+	qc2.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc2.initialLayout = {{0, 1}, {1, 0}};
+	qc2.outputPermutation = {{0, 1}, {1, 0}};
+
+	QuantumComputation qc3(nqubits);
+	qc3.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc3.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+	qc3.emplace_back<StandardOperation>(nqubits, 1, S);
+
+	for (const auto type: {StimuliType::Basis, StimuliType::Product}) {
+		RandomStimuliChecker equivalent(qc1, qc2);
+		equivalent.type = type;
+		equivalent.nthreads = 4;
+		equivalent.maxSimulations = 32;
+		auto result = equivalent.run();
+		EXPECT_TRUE(result.equivalent);
+		EXPECT_EQ(result.simulations, 32);
+
+		RandomStimuliChecker different(qc1, qc3);
+		different.type = type;
+		different.nthreads = 4;
+		different.maxSimulations = 32;
+		result = different.run();
+		EXPECT_FALSE(result.equivalent);
+		EXPECT_LT(result.fidelity, 1. - RandomStimuliChecker::DEFAULT_TOLERANCE);
+		if (type == StimuliType::Basis) {
+			EXPECT_EQ(result.basisState.size(), nqubits);
+		} else {
+			EXPECT_EQ(result.productState.size(), nqubits);
+		}
+	}
+
+	QuantumComputation qc4(3);
+	EXPECT_THROW(RandomStimuliChecker(qc1, qc4), QFRException);
+}
+
+TEST_F(QFRFunctionality, RandomStimuliEquivalenceCheckingAncillae) {
+	unsigned short nqubits = 3;
+	QuantumComputation qc1(nqubits);
+	qc1.emplace_back<StandardOperation>(nqubits, Control(0), 1, Z);
+
+	// CZ by means of an ancilla, which is only restored if it starts in |0>
+	QuantumComputation qc2(2);
+	qc2.addAncillaryRegister(1);
+	qc2.emplace_back<StandardOperation>(nqubits, std::vector<Control>{Control(0), Control(1)}, 2, X);
+	qc2.emplace_back<StandardOperation>(nqubits, 2, Z);
+	qc2.emplace_back<StandardOperation>(nqubits, std::vector<Control>{Control(0), Control(1)}, 2, X);
+
+	// the ancilla is not uncomputed, but its output is garbage
+	QuantumComputation qc3(2);
+	qc3.addAncillaryRegister(1);
+	qc3.emplace_back<StandardOperation>(nqubits, std::vector<Control>{Control(0), Control(1)}, 2, X);
+	qc3.emplace_back<StandardOperation>(nqubits, 2, Z);
+	qc3.setLogicalQubitGarbage(2);
+
+	QuantumComputation qc4(2);
+	qc4.addAncillaryRegister(1);
+	qc4.emplace_back<StandardOperation>(nqubits, std::vector<Control>{Control(0), Control(1)}, 2, X);
+	qc4.emplace_back<StandardOperation>(nqubits, 0, X);
+	qc4.setLogicalQubitGarbage(2);
+
+	for (const auto type: {StimuliType::Basis, StimuliType::Product}) {
+		for (auto* qc: {&qc2, &qc3}) {
+			RandomStimuliChecker equivalent(qc1, *qc);
+			equivalent.type = type;
+			equivalent.maxSimulations = 32;
+			auto result = equivalent.run();
+			EXPECT_TRUE(result.equivalent);
+			EXPECT_EQ(result.simulations, 32);
+		}
+
+		RandomStimuliChecker different(qc1, qc4);
+		different.type = type;
+		different.maxSimulations = 32;
+		auto result = different.run();
+		EXPECT_FALSE(result.equivalent);
+		// the ancilla starts in |0>
+		if (type == StimuliType::Basis) {
+			EXPECT_EQ(result.basisState.front(), '0');
+		} else {
+			EXPECT_EQ(result.productState.back().first, 0.);
+		}
+	}
+}
+
+TEST_F(QFRFunctionality, AlternatingMiter) {
+	unsigned short nqubits = 3;
+	QuantumComputation qc1(nqubits);
+	qc1.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc1.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+	qc1.emplace_back<StandardOperation>(nqubits, 1, T);
+	qc1.emplace_back<StandardOperation>(nqubits, std::vector<Control>{Control(0), Control(1)}, 2, X);
+	qc1.emplace_back<StandardOperation>(nqubits, std::vector<unsigned short>{0, 1}, SWAP);
+
+	// same functionality with a different decomposition and the SWAP absorbed into the output permutation
+	QuantumComputation qc2(nqubits);
+	qc2.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc2.emplace_back<StandardOperation>(nqubits, 1, H);
+	qc2.emplace_back<StandardOperation>(nqubits, Control(0), 1, Z);
+	qc2.emplace_back<StandardOperation>(nqubits, 1, H);
+	qc2.emplace_back<StandardOperation>(nqubits, 1, S);
+	qc2.emplace_back<StandardOperation>(nqubits, 1, Tdag);
+	qc2.emplace_back<StandardOperation>(nqubits, std::vector<Control>{Control(0), Control(1)}, 2, X);
+	qc2.outputPermutation = {{0, 1}, {1, 0}, {2, 2}};
+
+	QuantumComputation qc3(nqubits);
+	qc3.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc3.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+	qc3.emplace_back<StandardOperation>(nqubits, 1, Tdag);
+	qc3.emplace_back<StandardOperation>(nqubits, std::vector<Control>{Control(0), Control(1)}, 2, X);
+	qc3.outputPermutation = {{0, 1}, {1, 0}, {2, 2}};
+
+	for (const auto strategy: {MiterStrategy::Naive, MiterStrategy::Proportional, MiterStrategy::Lookahead}) {
+		MiterBuilder equivalent(qc1, qc2);
+		equivalent.strategy = strategy;
+		auto e = equivalent.build(dd);
+		EXPECT_TRUE(equivalent.isIdentity());
+		EXPECT_GT(equivalent.getMaxSize(), 0);
+		dd->decRef(e);
+
+		MiterBuilder different(qc1, qc3);
+		different.strategy = strategy;
+		e = different.build(dd);
+		EXPECT_FALSE(different.isIdentity());
+		dd->decRef(e);
+	}
+}
+
+TEST_F(QFRFunctionality, IncrementalFunctionalityRebuild) {
+	unsigned short nqubits = 3;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, 1, T);
+	qc.emplace_back<StandardOperation>(nqubits, 2, H);
+	qc.emplace_back<StandardOperation>(nqubits, std::vector<unsigned short>{0, 2}, SWAP);
+	qc.emplace_back<StandardOperation>(nqubits, Control(2), 0, Z);
+	qc.emplace_back<StandardOperation>(nqubits, 0, RY, 0.3);
+	qc.emplace_back<StandardOperation>(nqubits, std::vector<Control>{Control(0), Control(1)}, 2, X);
+	qc.emplace_back<StandardOperation>(nqubits, 1, S);
+	qc.emplace_back<StandardOperation>(nqubits, Control(1), 2, X);
+	qc.emplace_back<StandardOperation>(nqubits, 2, Tdag);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+
+	FunctionalityCheckpoints checkpoints(qc, dd);
+	auto e = checkpoints.build(3, true);
+	EXPECT_EQ(checkpoints.size(), 8);
+	auto reference = qc.buildFunctionality(dd);
+	EXPECT_TRUE(dd->equals(e, reference));
+	dd->decRef(reference);
+	dd->decRef(e);
+
+	// remove a gate after the SWAP
+	auto removed = (*(qc.begin() + 7))->clone();
+	qc.erase(qc.begin() + 7);
+	e = checkpoints.rebuild(7, 7);
+	reference = qc.buildFunctionality(dd);
+	EXPECT_TRUE(dd->equals(e, reference));
+	dd->decRef(reference);
+	dd->decRef(e);
+
+	// replace it by a different gate
+	qc.insert(qc.begin() + 7, std::make_unique<StandardOperation>(nqubits, Control(1), 0, Y));
+	e = checkpoints.rebuild(7, 8);
+	reference = qc.buildFunctionality(dd);
+	EXPECT_TRUE(dd->equals(e, reference));
+	dd->decRef(reference);
+	dd->decRef(e);
+	qc.erase(qc.begin() + 7);
+	qc.insert(qc.begin() + 7, std::move(removed));
+
+	// removing the SWAP changes the qubit mapping, so the suffix products cannot be reused
+	auto swap = (*(qc.begin() + 4))->clone();
+	qc.erase(qc.begin() + 4);
+	e = checkpoints.rebuild(4, 4);
+	reference = qc.buildFunctionality(dd);
+	EXPECT_TRUE(dd->equals(e, reference));
+	dd->decRef(reference);
+	dd->decRef(e);
+	qc.insert(qc.begin() + 4, std::move(swap));
+
+	EXPECT_THROW(checkpoints.rebuild(5, 4), QFRException);
+	checkpoints.clear();
+	EXPECT_EQ(checkpoints.size(), 0);
+	EXPECT_THROW(checkpoints.rebuild(0, 0), QFRException);
+}
+
+TEST_F(QFRFunctionality, SimulationSession) {
+	unsigned short nqubits = 3;
+	SimulationSession session(nqubits);
+	session.emplace<StandardOperation>(0, H);
+	session.emplace<StandardOperation>(Control(0), 1, X);
+	session.emplace<StandardOperation>(std::vector<unsigned short>{0, 2}, SWAP);
+	EXPECT_EQ(session.getNops(), 3);
+	EXPECT_NEAR(session.probability(0), 0., 1e-10);
+	EXPECT_NEAR(session.probability(1), 0.5, 1e-10);
+	EXPECT_NEAR(session.probability(2), 0.5, 1e-10);
+
+	const auto counts = session.sample(1000, 2, 42);
+	EXPECT_EQ(counts.size(), 2);
+	EXPECT_EQ(counts.count("000"), 1);
+	EXPECT_EQ(counts.count("110"), 1);
+
+	const auto id = session.checkpoint();
+	EXPECT_EQ(session.getNcheckpoints(), 1);
+	session.emplace<StandardOperation>(0, X);
+	session.emplace<NonUnitaryOperation>(std::vector<unsigned short>{0, 1, 2}, Barrier);
+	EXPECT_NEAR(session.probability(0), 1., 1e-10);
+	session.restore(id);
+	EXPECT_EQ(session.getNops(), 3);
+	EXPECT_NEAR(session.probability(0), 0., 1e-10);
+
+	// appending a circuit yields the same distribution as simulating everything at once
+	QuantumComputation prefix(nqubits);
+	prefix.emplace_back<StandardOperation>(nqubits, 0, H);
+	prefix.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+	prefix.emplace_back<StandardOperation>(nqubits, std::vector<unsigned short>{0, 2}, SWAP);
+	QuantumComputation suffix(nqubits);
+	suffix.emplace_back<StandardOperation>(nqubits, 2, RY, 0.7);
+	suffix.emplace_back<StandardOperation>(nqubits, Control(2), 0, X);
+	suffix.emplace_back<StandardOperation>(nqubits, 1, T);
+	session.applyBatch(suffix);
+	EXPECT_EQ(session.getNops(), 6);
+
+	for (auto& op: suffix) {
+		prefix.insert(prefix.end(), op->clone());
+	}
+	auto in = dd->makeZeroState(nqubits);
+	auto e = prefix.simulate(in, dd);
+	const std::vector<unsigned short> qubits{0, 1, 2};
+	const auto expected = QuantumComputation::getMarginalProbabilities(e, qubits, Operation::standardPermutation);
+	const auto actual = session.probabilities(qubits);
+	ASSERT_EQ(expected.size(), actual.size());
+	for (std::size_t i = 0; i < expected.size(); ++i) {
+		EXPECT_NEAR(expected[i], actual[i], 1e-10);
+	}
+	dd->decRef(e);
+
+	session.reset();
+	EXPECT_EQ(session.getNops(), 0);
+	EXPECT_NEAR(session.probability(2), 0., 1e-10);
+	EXPECT_THROW(session.probability(3), QFRException);
+	EXPECT_THROW(session.restore(5), QFRException);
+	EXPECT_THROW(session.emplace<NonUnitaryOperation>(std::vector<unsigned short>{0}, std::vector<unsigned short>{0}), QFRException);
+	session.releaseCheckpoints();
+	EXPECT_EQ(session.getNcheckpoints(), 0);
+}
+
+TEST_F(QFRFunctionality, StabilizerSimulation) {
+	unsigned short nqubits = 4;
+	QuantumComputation qc(nqubits);
+	qc.emplace_back<StandardOperation>(nqubits, 0, H);
+	qc.emplace_back<StandardOperation>(nqubits, Control(0), 1, X);
+	qc.emplace_back<StandardOperation>(nqubits, 2, V);
+	qc.emplace_back<StandardOperation>(nqubits, Control(1), 2, Y);
+	qc.emplace_back<StandardOperation>(nqubits, 1, S);
+	qc.emplace_back<StandardOperation>(nqubits, 3, H);
+	qc.emplace_back<StandardOperation>(nqubits, Control(3, Control::neg), 0, Z);
+	qc.emplace_back<StandardOperation>(nqubits, std::vector<unsigned short>{1, 3}, SWAP);
+	qc.emplace_back<StandardOperation>(nqubits, 0, Sdag);
+	qc.emplace_back<StandardOperation>(nqubits, 2, Vdag);
+	qc.emplace_back<StandardOperation>(nqubits, Control(2), 3, X);
+	qc.emplace_back<StandardOperation>(nqubits, 1, Y);
+	qc.emplace_back<NonUnitaryOperation>(nqubits, std::vector<unsigned short>{0, 1, 2, 3}, Barrier);
+	EXPECT_TRUE(qc.isClifford());
+
+	auto in = dd->makeZeroState(nqubits);
+	auto e = qc.simulate(in, dd);
+
+	// the tableau agrees with the state vector on all Pauli strings
+	StabilizerSimulator simulator(nqubits);
+	simulator.run(qc);
+	PauliExpectation reference(e, nqubits);
+	const std::string paulis = "IXYZ";
+	for (std::size_t i = 0; i < 256; ++i) {
+		std::string pauli{};
+		for (std::size_t k = 0, j = i; k < nqubits; ++k, j /= 4) {
+			pauli += paulis[j % 4];
+		}
+		EXPECT_NEAR(simulator.expectation(pauli), reference.expectation(pauli), 1e-8) << pauli;
+	}
+
+	auto f = simulator.toDD(dd);
+	dd->incRef(f);
+	EXPECT_NEAR(RandomStimuliChecker::fidelity(e, f), 1., 1e-8);
+	dd->decRef(f);
+
+	const auto expected = QuantumComputation::getMarginalProbabilities(e, {0, 1, 2, 3}, Operation::standardPermutation);
+	const auto counts = qc.sample(4000, dd, 7);
+	for (const auto& entry: counts) {
+		EXPECT_GT(expected[std::stoul(entry.first, nullptr, 2)], 1e-8) << entry.first;
+	}
+	EXPECT_NEAR(qc.expectationValue("ZZII", dd), reference.expectation("ZZII"), 1e-8);
+	dd->decRef(e);
+
+	// mid-circuit measurements are simulated per shot
+	QuantumComputation dynamic(2);
+	dynamic.emplace_back<StandardOperation>(2, 0, H);
+	dynamic.emplace_back<NonUnitaryOperation>(2, std::vector<unsigned short>{0}, std::vector<unsigned short>{0});
+	dynamic.emplace_back<StandardOperation>(2, Control(0), 1, X);
+	dynamic.emplace_back<NonUnitaryOperation>(2, std::vector<unsigned short>{0}, Reset);
+	EXPECT_TRUE(dynamic.isClifford());
+	const auto outcomes = dynamic.sample(200, dd, 3);
+	EXPECT_EQ(outcomes.size(), 2);
+	EXPECT_EQ(outcomes.count("00"), 1);
+	EXPECT_EQ(outcomes.count("10"), 1);
+
+	// the expectation value of a single measurement branch is not the expectation value of the circuit
+	EXPECT_THROW(dynamic.expectationValue("IZ", dd), QFRException);
+
+	// outputs without constraint are assigned in the same way as by the DD simulation
+	QuantumComputation partial(2);
+	partial.emplace_back<StandardOperation>(2, 0, X);
+	partial.emplace_back<NonUnitaryOperation>(2, std::vector<unsigned short>{0, 1}, Barrier);
+	partial.outputPermutation = {{0, 1}};
+	EXPECT_TRUE(partial.isClifford());
+	const auto clifford = partial.sample(10, dd);
+	EXPECT_EQ(clifford.size(), 1);
+	EXPECT_EQ(clifford.count("10"), 1);
+	EXPECT_NEAR(partial.expectationValue("ZI", dd), -1., 1e-8);
+	EXPECT_NEAR(partial.expectationValue("IZ", dd), 1., 1e-8);
+	partial.emplace_back<StandardOperation>(2, 1, T);
+	EXPECT_FALSE(partial.isClifford());
+	EXPECT_EQ(partial.sample(10, dd), clifford);
+
+	StabilizerSimulator bell(2, 1);
+	bell.h(0);
+	bell.cx(0, 1);
+	EXPECT_FALSE(bell.isDeterministic(1));
+	const auto first = bell.measure(0);
+	EXPECT_TRUE(bell.isDeterministic(1));
+	EXPECT_EQ(bell.measure(1), first);
+
+	qc.emplace_back<StandardOperation>(nqubits, 0, T);
+	EXPECT_FALSE(qc.isClifford());
+	EXPECT_THROW(simulator.run(qc), QFRException);
+	EXPECT_THROW(simulator.expectation("XX"), QFRException);
+}